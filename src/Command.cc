@@ -83,6 +83,7 @@ namespace
       _T( HELP_e )		| "help"		| "?";
       _T( SHELL_e )		| "shell"		| "sh";
       _T( SHELL_QUIT_e )	| "quit"		| "exit" | "\004";
+      _T( SERVE_e )		| "serve";
       _T( MOO_e )		| "moo";
 
       _T( RUG_PATCH_INFO_e )	| "patch-info";
@@ -157,6 +158,7 @@ DEF_ZYPPER_COMMAND( SOURCE_DOWNLOAD );
 DEF_ZYPPER_COMMAND( HELP );
 DEF_ZYPPER_COMMAND( SHELL );
 DEF_ZYPPER_COMMAND( SHELL_QUIT );
+DEF_ZYPPER_COMMAND( SERVE );
 DEF_ZYPPER_COMMAND( NONE );
 DEF_ZYPPER_COMMAND( MOO );
 
@@ -73,6 +73,7 @@ struct ZypperCommand
   static const ZypperCommand HELP;
   static const ZypperCommand SHELL;
   static const ZypperCommand SHELL_QUIT;
+  static const ZypperCommand SERVE;
   static const ZypperCommand MOO;
 
   //!@{
@@ -146,6 +147,7 @@ struct ZypperCommand
     HELP_e,
     SHELL_e,
     SHELL_QUIT_e,
+    SERVE_e,
     MOO_e,
 
     RUG_PATCH_INFO_e,
@@ -18,7 +18,7 @@ extern "C"
 #include <zypp/base/Exception.h>
 #include <zypp/ZConfig.h>
 
-#include "utils/Augeas.h"
+#include "utils/ConfigReader.h"
 #include "Config.h"
 
 // redefine _ gettext macro defined by ZYpp
@@ -34,6 +34,13 @@ const ConfigOption ConfigOption::MAIN_SHOW_ALIAS(ConfigOption::MAIN_SHOW_ALIAS_e
 const ConfigOption ConfigOption::MAIN_REPO_LIST_COLUMNS(ConfigOption::MAIN_REPO_LIST_COLUMNS_e);
 const ConfigOption ConfigOption::SOLVER_INSTALL_RECOMMENDS(ConfigOption::SOLVER_INSTALL_RECOMMENDS_e);
 const ConfigOption ConfigOption::SOLVER_FORCE_RESOLUTION_COMMANDS(ConfigOption::SOLVER_FORCE_RESOLUTION_COMMANDS_e);
+const ConfigOption ConfigOption::SOLVER_SOLUTION_CACHE(ConfigOption::SOLVER_SOLUTION_CACHE_e);
+const ConfigOption ConfigOption::COMMIT_DOWNLOAD_JOBS(ConfigOption::COMMIT_DOWNLOAD_JOBS_e);
+const ConfigOption ConfigOption::COMMIT_DOWNLOAD_BUDGET(ConfigOption::COMMIT_DOWNLOAD_BUDGET_e);
+
+const ConfigOption ConfigOption::CACHE_PACKAGES_BUDGET(ConfigOption::CACHE_PACKAGES_BUDGET_e);
+const ConfigOption ConfigOption::CACHE_PACKAGES_MAX_AGE(ConfigOption::CACHE_PACKAGES_MAX_AGE_e);
+const ConfigOption ConfigOption::CACHE_PACKAGES_STORE(ConfigOption::CACHE_PACKAGES_STORE_e);
 const ConfigOption ConfigOption::COLOR_USE_COLORS(ConfigOption::COLOR_USE_COLORS_e);
 const ConfigOption ConfigOption::COLOR_BACKGROUND(ConfigOption::COLOR_BACKGROUND_e);
 const ConfigOption ConfigOption::COLOR_RESULT(ConfigOption::COLOR_RESULT_e);
@@ -60,6 +67,12 @@ namespace
       { "main/repoListColumns",			ConfigOption::MAIN_REPO_LIST_COLUMNS_e		},
       { "solver/installRecommends",		ConfigOption::SOLVER_INSTALL_RECOMMENDS_e	},
       { "solver/forceResolutionCommands",	ConfigOption::SOLVER_FORCE_RESOLUTION_COMMANDS_e},
+      { "solver/solutionCache",			ConfigOption::SOLVER_SOLUTION_CACHE_e		},
+      { "commit/downloadJobs",			ConfigOption::COMMIT_DOWNLOAD_JOBS_e		},
+      { "commit/downloadBudget",		ConfigOption::COMMIT_DOWNLOAD_BUDGET_e		},
+      { "cache/packagesBudget",			ConfigOption::CACHE_PACKAGES_BUDGET_e		},
+      { "cache/packagesMaxAge",			ConfigOption::CACHE_PACKAGES_MAX_AGE_e		},
+      { "cache/packagesStore",			ConfigOption::CACHE_PACKAGES_STORE_e		},
       { "color/useColors",			ConfigOption::COLOR_USE_COLORS_e		},
       { "color/background",			ConfigOption::COLOR_BACKGROUND_e		},
       { "color/result",				ConfigOption::COLOR_RESULT_e			},
@@ -133,6 +146,10 @@ Config::Config()
   : show_alias(false)
   , repo_list_columns("anr")
   , solver_installRecommends(!ZConfig::instance().solver_onlyRequires())
+  , commit_downloadJobs(4)
+  , commit_downloadBudget(1024, ByteCount::M)
+  , cache_packagesBudget(0)
+  , cache_packagesMaxAge(0)
   , do_colors        (false)
   , color_useColors  ("never")
   , color_background (false)    // dark background
@@ -155,32 +172,32 @@ void Config::read(const string & file)
     debug::Measure m("ReadConfig");
     string s;
 
-    Augeas augeas(file);
+    ConfigReader conf(file);
 
     m.elapsed();
 
     // ---------------[ main ]--------------------------------------------------
 
-    s = augeas.getOption(ConfigOption::MAIN_SHOW_ALIAS.asString());
+    s = conf.getOption(ConfigOption::MAIN_SHOW_ALIAS.asString());
     if (!s.empty())
     {
       show_alias = str::strToBool(s, false);
       ZConfig::instance().repoLabelIsAlias(show_alias);
     }
 
-    s = augeas.getOption(ConfigOption::MAIN_REPO_LIST_COLUMNS.asString());
+    s = conf.getOption(ConfigOption::MAIN_REPO_LIST_COLUMNS.asString());
     if (!s.empty()) // TODO add some validation
       repo_list_columns = s;
 
     // ---------------[ solver ]------------------------------------------------
 
-    s = augeas.getOption(ConfigOption::SOLVER_INSTALL_RECOMMENDS.asString());
+    s = conf.getOption(ConfigOption::SOLVER_INSTALL_RECOMMENDS.asString());
     if (s.empty())
       solver_installRecommends = !ZConfig::instance().solver_onlyRequires();
     else
       solver_installRecommends = str::strToBool(s, true);
 
-    s = augeas.getOption(ConfigOption::SOLVER_FORCE_RESOLUTION_COMMANDS.asString());
+    s = conf.getOption(ConfigOption::SOLVER_FORCE_RESOLUTION_COMMANDS.asString());
     if (s.empty())
       solver_forceResolutionCommands.insert(ZypperCommand::REMOVE);
     else
@@ -191,17 +208,69 @@ void Config::read(const string & file)
         solver_forceResolutionCommands.insert(ZypperCommand(str::trim(*c)));
     }
 
+    s = conf.getOption(ConfigOption::SOLVER_SOLUTION_CACHE.asString());
+    if (!s.empty())
+    {
+      if (s[0] == '/')
+        solver_solutionCache = s;
+      else
+        ERR << "solver/solutionCache must be an absolute path: " << s << endl;
+    }
+
+
+    // ---------------[ commit ]------------------------------------------------
+
+    s = conf.getOption(ConfigOption::COMMIT_DOWNLOAD_JOBS.asString());
+    if (!s.empty())
+    {
+      unsigned jobs = str::strtonum<unsigned>(s);
+      if (jobs)
+        commit_downloadJobs = jobs;
+      else
+        ERR << "invalid commit/downloadJobs value: " << s << endl;
+    }
+
+    s = conf.getOption(ConfigOption::COMMIT_DOWNLOAD_BUDGET.asString());
+    if (!s.empty())
+    {
+      unsigned budget = str::strtonum<unsigned>(s);
+      if (budget)
+        commit_downloadBudget = ByteCount(budget, ByteCount::M);
+      else
+        ERR << "invalid commit/downloadBudget value: " << s << endl;
+    }
+
+
+    // ---------------[ cache ]-------------------------------------------------
+
+    s = conf.getOption(ConfigOption::CACHE_PACKAGES_BUDGET.asString());
+    if (!s.empty())
+      cache_packagesBudget = ByteCount(str::strtonum<unsigned>(s), ByteCount::M);
+
+    s = conf.getOption(ConfigOption::CACHE_PACKAGES_MAX_AGE.asString());
+    if (!s.empty())
+      cache_packagesMaxAge = str::strtonum<unsigned>(s);
+
+    s = conf.getOption(ConfigOption::CACHE_PACKAGES_STORE.asString());
+    if (!s.empty())
+    {
+      if (s[0] == '/')
+        cache_packagesStore = s;
+      else
+        ERR << "cache/packagesStore must be an absolute path: " << s << endl;
+    }
+
 
     // ---------------[ colors ]------------------------------------------------
 
-    color_useColors = augeas.getOption(ConfigOption::COLOR_USE_COLORS.asString());
+    color_useColors = conf.getOption(ConfigOption::COLOR_USE_COLORS.asString());
     do_colors =
       (color_useColors == "autodetect" && has_colors())
       || color_useColors == "always";
 
     ////// color/background //////
 
-    s = augeas.getOption(ConfigOption::COLOR_BACKGROUND.asString());
+    s = conf.getOption(ConfigOption::COLOR_BACKGROUND.asString());
     if (s == "light")
       color_background = true;
     else if (!s.empty() && s != "dark")
@@ -211,7 +280,7 @@ void Config::read(const string & file)
 
     ////// color/colorResult //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_RESULT.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_RESULT.asString()));
     if (c.value().empty())
     {
       // set a default for light background
@@ -223,7 +292,7 @@ void Config::read(const string & file)
 
     ////// color/colorMsgStatus //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_MSG_STATUS.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_MSG_STATUS.asString()));
     if (c.value().empty())
     {
       // set a default for light background
@@ -235,13 +304,13 @@ void Config::read(const string & file)
 
     ////// color/colorMsgError //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_MSG_ERROR.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_MSG_ERROR.asString()));
     if (!c.value().empty())
       color_msgError = c;
 
     ////// color/colorMsgWarning //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_MSG_WARNING.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_MSG_WARNING.asString()));
     if (c.value().empty())
     {
       // set a default for light background
@@ -253,25 +322,25 @@ void Config::read(const string & file)
 
     ////// color/colorPositive //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_POSITIVE.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_POSITIVE.asString()));
     if (!c.value().empty())
       color_positive = c;
 
     ////// color/colorNegative //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_NEGATIVE.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_NEGATIVE.asString()));
     if (!c.value().empty())
       color_negative = c;
 
     ////// color/highlight //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_HIGHLIGHT.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_HIGHLIGHT.asString()));
     if (!c.value().empty())
       color_highlight = c;
 
     ////// color/colorPromptOption //////
 
-    c = Color(augeas.getOption(ConfigOption::COLOR_PROMPT_OPTION.asString()));
+    c = Color(conf.getOption(ConfigOption::COLOR_PROMPT_OPTION.asString()));
     if (c.value().empty())
     {
       // set a default for light background
@@ -284,7 +353,7 @@ void Config::read(const string & file)
 
     // ---------------[ obs ]---------------------------------------------------
 
-    s = augeas.getOption(ConfigOption::OBS_BASE_URL.asString());
+    s = conf.getOption(ConfigOption::OBS_BASE_URL.asString());
     if (!s.empty())
     {
       try { obs_baseUrl = Url(s); }
@@ -294,7 +363,7 @@ void Config::read(const string & file)
       }
     }
 
-    s = augeas.getOption(ConfigOption::OBS_PLATFORM.asString());
+    s = conf.getOption(ConfigOption::OBS_PLATFORM.asString());
     if (!s.empty())
       obs_platform = s;
 
@@ -303,6 +372,6 @@ void Config::read(const string & file)
   catch (Exception & e)
   {
     std::cerr << e.asUserHistory() << endl;
-    std::cerr << "*** Augeas exception. No config read, sticking with defaults." << endl;
+    std::cerr << "*** Config exception. No config read, sticking with defaults." << endl;
   }
 }
@@ -12,6 +12,7 @@
 #include <set>
 
 #include <zypp/Url.h>
+#include <zypp/ByteCount.h>
 #include "Command.h"
 #include "utils/colors.h"
 
@@ -23,6 +24,14 @@ public:
 
   static const ConfigOption SOLVER_INSTALL_RECOMMENDS;
   static const ConfigOption SOLVER_FORCE_RESOLUTION_COMMANDS;
+  static const ConfigOption SOLVER_SOLUTION_CACHE;
+
+  static const ConfigOption COMMIT_DOWNLOAD_JOBS;
+  static const ConfigOption COMMIT_DOWNLOAD_BUDGET;
+
+  static const ConfigOption CACHE_PACKAGES_BUDGET;
+  static const ConfigOption CACHE_PACKAGES_MAX_AGE;
+  static const ConfigOption CACHE_PACKAGES_STORE;
 
   static const ConfigOption COLOR_USE_COLORS;
   static const ConfigOption COLOR_BACKGROUND;
@@ -46,6 +55,14 @@ public:
 
     SOLVER_INSTALL_RECOMMENDS_e,
     SOLVER_FORCE_RESOLUTION_COMMANDS_e,
+    SOLVER_SOLUTION_CACHE_e,
+
+    COMMIT_DOWNLOAD_JOBS_e,
+    COMMIT_DOWNLOAD_BUDGET_e,
+
+    CACHE_PACKAGES_BUDGET_e,
+    CACHE_PACKAGES_MAX_AGE_e,
+    CACHE_PACKAGES_STORE_e,
 
     COLOR_USE_COLORS_e,
     COLOR_BACKGROUND_e,
@@ -97,6 +114,20 @@ struct Config
 
   bool solver_installRecommends;
   std::set<ZypperCommand> solver_forceResolutionCommands;
+  /** zypper.conf: solver.solutionCache (empty if not used) */
+  zypp::Pathname solver_solutionCache;
+
+  /** zypper.conf: commit.downloadJobs */
+  unsigned commit_downloadJobs;
+  /** zypper.conf: commit.downloadBudget (MiB) */
+  zypp::ByteCount commit_downloadBudget;
+
+  /** zypper.conf: cache.packagesBudget (MiB, 0 means no limit) */
+  zypp::ByteCount cache_packagesBudget;
+  /** zypper.conf: cache.packagesMaxAge (days, 0 means no limit) */
+  unsigned cache_packagesMaxAge;
+  /** zypper.conf: cache.packagesStore (empty if not used) */
+  zypp::Pathname cache_packagesStore;
 
   /**
    * Whether to colorize the output. This is evaluated according to
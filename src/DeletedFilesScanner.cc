@@ -0,0 +1,231 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <dirent.h>
+#include <pwd.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/Package.h>
+
+#include "DeletedFilesScanner.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  const string deletedSuffix( " (deleted)" );
+
+  /** Deleted files nobody needs to restart anything for. */
+  bool ignored( const string & file_r )
+  {
+    return str::hasPrefix( file_r, "/dev/" )
+        || str::hasPrefix( file_r, "/SYSV" )
+        || str::hasPrefix( file_r, "/memfd:" )
+        || str::hasPrefix( file_r, "/tmp/" )
+        || str::hasPrefix( file_r, "/var/tmp/" )
+        || str::hasPrefix( file_r, "/run/" );
+  }
+
+  vector<string> listPids()
+  {
+    vector<string> ret;
+    DIR * dir = ::opendir( "/proc" );
+    if ( ! dir )
+    {
+      ERR << "can't read /proc" << endl;
+      return ret;
+    }
+    string self( str::numstring( ::getpid() ) );
+    while ( struct dirent * entry = ::readdir( dir ) )
+    {
+      if ( ::isdigit( (unsigned char)entry->d_name[0] ) && self != entry->d_name )
+        ret.push_back( entry->d_name );
+    }
+    ::closedir( dir );
+    return ret;
+  }
+
+  /** \a dir_r with its symlinks resolved as if chrooted to \a root_r.
+   * Components which don't exist are kept as they are. */
+  string resolveDir( const Pathname & root_r, const string & dir_r )
+  {
+    list<string> todo;
+    str::split( dir_r, back_inserter( todo ), "/" );
+    string resolved;	// below root_r, "" for itself
+    unsigned links = 0;
+    while ( ! todo.empty() )
+    {
+      string comp( todo.front() );
+      todo.pop_front();
+      if ( comp == "." )
+        continue;
+      if ( comp == ".." )
+      {
+        resolved.erase( std::min( resolved.rfind( '/' ), resolved.size() ) );
+        continue;
+      }
+      string next( resolved + "/" + comp );
+      char target[PATH_MAX];
+      ssize_t len = ::readlink( ( root_r / next ).c_str(), target, sizeof(target) );
+      if ( len <= 0 || len == ssize_t( sizeof(target) ) || ++links > 40 )
+      {
+        resolved = next;	// not a symlink (EINVAL), or not there
+        continue;
+      }
+      if ( target[0] == '/' )
+        resolved.clear();
+      list<string> parts;
+      str::split( string( target, len ), back_inserter( parts ), "/" );
+      todo.splice( todo.begin(), parts );
+    }
+    return resolved.empty() ? "/" : resolved;
+  }
+
+  bool byPid( const CheckAccessDeleted::ProcInfo & lhs, const CheckAccessDeleted::ProcInfo & rhs )
+  { return ::atol( lhs.pid.c_str() ) < ::atol( rhs.pid.c_str() ); }
+} // namespace
+
+DeletedFilesScanner::DeletedFilesScanner( unsigned threads_r )
+  : _threads( threads_r )
+  , _restricted( false )
+{
+  if ( ! _threads )
+    _threads = std::min( std::max( std::thread::hardware_concurrency(), 1U ), 8U );
+}
+
+DeletedFilesScanner::Result DeletedFilesScanner::scan() const
+{
+  Result ret;
+  if ( _restricted && _files.empty() )
+  {
+    DBG << "no files removed, nothing to scan" << endl;
+    return ret;
+  }
+
+  vector<string> pids( listPids() );
+  unsigned threads = std::min<unsigned>( _threads, pids.size() );
+  vector<Result> results( threads );
+  std::atomic<unsigned> next( 0 );
+
+  // the processes are handed out one by one, their maps vary a lot in size
+  auto worker = [&]( unsigned idx_r ) {
+    for ( unsigned i = next++; i < pids.size(); i = next++ )
+    {
+      CheckAccessDeleted::ProcInfo info;
+      if ( scanProcess( pids[i], info ) )
+        results[idx_r].push_back( info );
+    }
+  };
+  vector<std::thread> pool;
+  for ( unsigned i = 1; i < threads; ++i )
+    pool.push_back( std::thread( worker, i ) );
+  if ( threads )
+    worker( 0 );
+  for_( it, pool.begin(), pool.end() )
+    it->join();
+
+  for_( it, results.begin(), results.end() )
+    ret.insert( ret.end(), it->begin(), it->end() );
+  std::sort( ret.begin(), ret.end(), byPid );
+  MIL << "scanned " << pids.size() << " processes using " << threads << " threads"
+      << ( _restricted ? " for " + str::numstring( _files.size() ) + " files" : string() )
+      << ": " << ret.size() << " use deleted files" << endl;
+  return ret;
+}
+
+bool DeletedFilesScanner::scanProcess( const string & pid_r, CheckAccessDeleted::ProcInfo & info_r ) const
+{
+  string procdir( "/proc/" + pid_r );
+  ifstream maps( ( procdir + "/maps" ).c_str() );
+  set<string> files;
+  string line;
+  while ( getline( maps, line ) )
+  {
+    if ( ! str::hasSuffix( line, deletedSuffix ) )
+      continue;
+    string::size_type pos = line.find( '/' );
+    if ( pos == string::npos )
+      continue;
+    string file( line, pos, line.size() - pos - deletedSuffix.size() );
+    if ( _restricted ? _files.count( file ) : ! ignored( file ) )
+      files.insert( file );
+  }
+  if ( files.empty() )
+    return false;	// also if it's gone or we may not look at it
+
+  info_r.pid = pid_r;
+  info_r.files.assign( files.begin(), files.end() );
+
+  struct stat st;
+  if ( ::stat( procdir.c_str(), &st ) == 0 )
+  {
+    info_r.puid = str::numstring( st.st_uid );
+    struct passwd pwd;
+    struct passwd * result = 0;
+    char buf[1024];
+    if ( ::getpwuid_r( st.st_uid, &pwd, buf, sizeof(buf), &result ) == 0 && result )
+      info_r.login = pwd.pw_name;
+  }
+
+  ifstream comm( ( procdir + "/comm" ).c_str() );
+  getline( comm, info_r.command );
+
+  // pid (comm) state ppid ...; comm may contain anything
+  ifstream stat( ( procdir + "/stat" ).c_str() );
+  getline( stat, line );
+  string::size_type pos = line.rfind( ')' );
+  if ( pos != string::npos )
+  {
+    vector<string> fields;
+    str::split( line.substr( pos + 1 ), back_inserter( fields ) );
+    if ( fields.size() > 1 )
+      info_r.ppid = fields[1];
+  }
+  return true;
+}
+
+DeletedFilesScanner::Files DeletedFilesScanner::filesRemovedBy( const ResPool & pool_r,
+                                                                const Pathname & root_r )
+{
+  Files ret;
+  // the maps show the canonical paths: /lib64/libc.so.6 is mapped as
+  // /usr/lib64/libc.so.6 on usrmerged systems
+  unordered_map<string, string> dirs;
+  for_( it, pool_r.byKindBegin<Package>(), pool_r.byKindEnd<Package>() )
+  {
+    // upgraded packages' old versions, too
+    if ( ! ( it->status().isInstalled() && it->status().isToBeUninstalled() ) )
+      continue;
+    auto files( asKind<Package>( it->resolvable() )->filelist() );
+    for_( file, files.begin(), files.end() )
+    {
+      Pathname path( *file );
+      string dir( path.dirname().asString() );
+      auto known( dirs.find( dir ) );
+      if ( known == dirs.end() )
+        known = dirs.insert( make_pair( dir, resolveDir( root_r, dir ) ) ).first;
+      ret.insert( ( root_r / known->second / path.basename() ).asString() );
+    }
+  }
+  DBG << ret.size() << " files to be removed or replaced" << endl;
+  return ret;
+}
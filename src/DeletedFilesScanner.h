@@ -0,0 +1,67 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_DELETEDFILESSCANNER_H_
+#define ZYPPER_DELETEDFILESSCANNER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include <zypp/Pathname.h>
+#include <zypp/ResPool.h>
+#include <zypp/misc/CheckAccessDeleted.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class DeletedFilesScanner
+/// \brief Find running processes using deleted files, using several threads.
+///
+/// Reads the memory maps of all processes in /proc, like
+/// zypp::CheckAccessDeleted does via lsof for the executables and
+/// libraries, but spreads the processes over several threads.
+///
+/// After a commit there is no need to look for anything but the files
+/// the transaction removed or replaced: \ref restrictTo those of
+/// \ref filesRemovedBy the transaction (collected before the commit),
+/// and nothing gets scanned at all if it did not remove any.
+///////////////////////////////////////////////////////////////////
+class DeletedFilesScanner
+{
+public:
+  typedef std::vector<zypp::CheckAccessDeleted::ProcInfo> Result;
+  typedef std::unordered_set<std::string> Files;
+
+public:
+  /** Scan using \a threads_r threads, 0 meaning one per CPU (at most 8). */
+  DeletedFilesScanner( unsigned threads_r = 0 );
+
+  /** Report only the \a files_r, none if empty. */
+  void restrictTo( const Files & files_r )
+  { _files = files_r; _restricted = true; }
+
+  /** The processes using deleted files, by PID, except this one. */
+  Result scan() const;
+
+  /** The files of the packages in \a pool_r which are to be removed or
+   * replaced, as seen from the system root (\a root_r prefixed), with
+   * their directories' symlinks resolved. Call it before the commit, while
+   * the directories still exist.
+   */
+  static Files filesRemovedBy( const zypp::ResPool & pool_r,
+                               const zypp::Pathname & root_r = "/" );
+
+private:
+  /** Whether \a pid_r uses deleted files, and which. */
+  bool scanProcess( const std::string & pid_r, zypp::CheckAccessDeleted::ProcInfo & info_r ) const;
+
+private:
+  unsigned _threads;
+  bool _restricted;
+  Files _files;
+};
+
+#endif /* ZYPPER_DELETEDFILESSCANNER_H_ */
@@ -37,6 +37,17 @@ PackageArgs::PackageArgs(
   argsToCaps(kind);
 }
 
+PackageArgs::PackageArgs(
+    istream & manifest,
+    const zypp::ResKind & kind,
+    const Options & opts)
+  : zypper(*Zypper::instance()), _opts(opts)
+{
+  preprocess(zypper.arguments());
+  readManifest(manifest);
+  argsToCaps(kind);
+}
+
 // ---------------------------------------------------------------------------
 
 void PackageArgs::preprocess(const vector<string> & args)
@@ -105,6 +116,46 @@ void PackageArgs::preprocess(const vector<string> & args)
 
 // ---------------------------------------------------------------------------
 
+void PackageArgs::readManifest(istream & manifest)
+{
+  unsigned count = 0;
+  unsigned lineno = 0;
+  string line;
+  while (getline(manifest, line))
+  {
+    ++lineno;
+    vector<string> words;
+    str::split(line.substr(0, line.find('#')), back_inserter(words), " \t\r\v\f");
+    if (words.empty())
+      continue;
+
+    // whitespace is allowed around operators only, like on the command
+    // line: 'name >= 1.0' is one argument, 'foo bar' a mistake
+    string arg(words.front());
+    for (unsigned i = 1; i < words.size(); ++i)
+    {
+      if (arg.find_last_of("=<>") != arg.size() - 1
+          && words[i].find_first_of("=<>") != 0)
+      {
+        zypper.out().error(str::form(
+            _("Line %u of the package list holds more than one package: '%s'"),
+            lineno, str::trim(line).c_str()),
+            _("Put each package on a line of its own."));
+        zypper.setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+        ZYPP_THROW(ExitRequestException());
+      }
+      arg += words[i];
+    }
+
+    _args.insert(arg);
+    ++count;
+  }
+
+  DBG << "args read from manifest: " << count << endl;
+}
+
+// ---------------------------------------------------------------------------
+
 static bool
 remove_duplicate(
     PackageArgs::PackageSpecSet & set, const PackageSpec & obj)
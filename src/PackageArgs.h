@@ -73,6 +73,15 @@ public:
       const zypp::ResKind & kind = zypp::ResKind::package,
       const Options & opts = Options());
 
+  /**
+   * Processes current Zypper::arguments() plus the package manifest
+   * \a manifest, one argument per line (see \ref readManifest).
+   */
+  PackageArgs(
+      std::istream & manifest,
+      const zypp::ResKind & kind = zypp::ResKind::package,
+      const Options & opts = Options());
+
   ~PackageArgs() {}
 
   const Options & options() const
@@ -94,6 +103,13 @@ public:
 protected:
   /** join arguments at comparison operators ('=', '>=', and the like) */
   void preprocess(const std::vector<std::string> & args);
+  /**
+   * Read arguments from \a manifest, one per line, like 'repo:name>=1.0'
+   * or '-name'. Anything after a '#' is ignored, so is whitespace at the
+   * ends and around operators.
+   * \throws ExitRequestException if a line holds several arguments
+   */
+  void readManifest(std::istream & manifest);
   void argsToCaps(const zypp::ResKind & kind);
 
 private:
@@ -0,0 +1,177 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/PathInfo.h>
+#include <zypp/Package.h>
+
+#include "PackageCache.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  struct CachedFile
+  {
+    Pathname path;
+    time_t used;
+    ByteCount size;
+
+    bool operator<( const CachedFile & rhs ) const
+    { return used < rhs.used; }
+  };
+
+  /** Collect the package files below \a dir_r. */
+  void collectFiles( const Pathname & dir_r, vector<CachedFile> & files_r )
+  {
+    list<filesystem::DirEntry> entries;
+    if ( filesystem::readdir( entries, dir_r, false ) != 0 )
+      return;
+
+    for_( it, entries.begin(), entries.end() )
+    {
+      Pathname path( dir_r / it->name );
+      if ( it->type == filesystem::FT_DIR )
+        collectFiles( path, files_r );
+      else if ( it->type == filesystem::FT_FILE
+                && ( str::hasSuffix( it->name, ".rpm" ) || str::hasSuffix( it->name, ".drpm" ) ) )
+      {
+        PathInfo pi( path );
+        CachedFile f;
+        f.path = path;
+        // a download sets the mtime, a hit the atime
+        f.used = std::max( pi.atime(), pi.mtime() );
+        f.size = pi.size();
+        files_r.push_back( f );
+      }
+    }
+  }
+
+  /** Set the access time of \a path_r to now, leaving the mtime alone. */
+  void markUsed( const Pathname & path_r )
+  {
+    struct timespec times[2];
+    times[0].tv_sec = 0;
+    times[0].tv_nsec = UTIME_NOW;
+    times[1].tv_sec = 0;
+    times[1].tv_nsec = UTIME_OMIT;
+    if ( ::utimensat( AT_FDCWD, path_r.c_str(), times, 0 ) != 0 )
+      WAR << "can't update atime of " << path_r << endl;
+  }
+} // namespace
+
+PackageCache::PackageCache( const Pathname & root_r )
+  : _root( root_r )
+{
+  loadStats();
+}
+
+void PackageCache::commitStarts( const ResPool & pool_r )
+{
+  for_( it, pool_r.byKindBegin<Package>(), pool_r.byKindEnd<Package>() )
+  {
+    if ( ! it->status().isToBeInstalled() )
+      continue;
+    Package::constPtr pkg( asKind<Package>( it->resolvable() ) );
+    if ( ! pkg->repoInfo().url().schemeIsDownloading() )
+      continue;	// not cached anyway
+
+    Pathname cached( pkg->repoInfo().packagesPath() / pkg->location().filename() );
+    if ( PathInfo( cached ).isFile() )
+    {
+      ++_stats.hits;
+      _stats.saved += pkg->downloadSize();
+      markUsed( cached );
+    }
+    else
+    {
+      ++_stats.misses;
+      _stats.downloaded += pkg->downloadSize();
+    }
+  }
+  saveStats();
+}
+
+PackageCache::Eviction PackageCache::enforce( const ByteCount & budget_r, unsigned maxAgeDays_r,
+                                              time_t keepSince_r )
+{
+  vector<CachedFile> files;
+  collectFiles( _root, files );
+  std::sort( files.begin(), files.end() );
+
+  Eviction ret;
+  for_( it, files.begin(), files.end() )
+    ret.left += it->size;
+
+  time_t maxAge = ::time( 0 ) - time_t( maxAgeDays_r ) * 24 * 60 * 60;
+  for_( it, files.begin(), files.end() )
+  {
+    bool tooOld = maxAgeDays_r && it->used < maxAge;
+    bool overBudget = budget_r && ret.left > budget_r;
+    if ( ! ( tooOld || overBudget ) )
+      break;	// least recently used first, so the rest is fine too
+    if ( keepSince_r && it->used >= keepSince_r )
+      break;
+
+    if ( filesystem::unlink( it->path ) == 0 )
+    {
+      DBG << "evicted " << it->path << " (" << it->size << ")" << endl;
+      ++ret.files;
+      ret.bytes += it->size;
+      ret.left -= it->size;
+    }
+  }
+  MIL << "evicted " << ret.files << " packages (" << ret.bytes << "), " << ret.left << " left" << endl;
+  return ret;
+}
+
+void PackageCache::loadStats()
+{
+  ifstream in( ( _root / ".zypper-stats" ).c_str() );
+  string key;
+  unsigned long long value;
+  while ( in >> key >> value )
+  {
+    if ( key == "hits" )
+      _stats.hits = value;
+    else if ( key == "misses" )
+      _stats.misses = value;
+    else if ( key == "saved" )
+      _stats.saved = value;
+    else if ( key == "downloaded" )
+      _stats.downloaded = value;
+  }
+}
+
+void PackageCache::saveStats() const
+{
+  filesystem::assert_dir( _root );
+  Pathname file( _root / ".zypper-stats" );
+  Pathname tmp( file.extend( ".new" ) );
+  {
+    ofstream out( tmp.c_str() );
+    out << "hits " << _stats.hits << endl
+        << "misses " << _stats.misses << endl
+        << "saved " << ByteCount::SizeType( _stats.saved ) << endl
+        << "downloaded " << ByteCount::SizeType( _stats.downloaded ) << endl;
+    if ( ! out )
+    {
+      WAR << "can't write " << tmp << endl;
+      return;
+    }
+  }
+  filesystem::rename( tmp, file );
+}
@@ -0,0 +1,86 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_PACKAGECACHE_H_
+#define ZYPPER_PACKAGECACHE_H_
+
+#include <ctime>
+
+#include <zypp/Pathname.h>
+#include <zypp/ByteCount.h>
+#include <zypp/ResPool.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class PackageCache
+/// \brief The package caches of all repositories, kept within limits.
+///
+/// Packages are evicted least recently used first until the cache fits
+/// into a byte budget, and regardless of that when they were not used
+/// for a given number of days. A package counts as used when it gets
+/// downloaded, and when a commit finds it in the cache instead of
+/// downloading it (its access time is updated explicitly, so this works
+/// on noatime mounts, too).
+///
+/// These hits and misses are counted across zypper runs in a stats file
+/// in the cache directory, to tell whether the limits are worth their
+/// re-downloads.
+///////////////////////////////////////////////////////////////////
+class PackageCache
+{
+public:
+  struct Stats
+  {
+    Stats() : hits( 0 ), misses( 0 ) {}
+
+    /** Percentage of packages found in the cache, -1 if nothing was committed yet. */
+    int hitRate() const
+    { return hits + misses ? hits * 100 / ( hits + misses ) : -1; }
+
+    unsigned long long hits;
+    unsigned long long misses;
+    zypp::ByteCount saved;	//< download size of the hits
+    zypp::ByteCount downloaded;	//< download size of the misses
+  };
+
+  struct Eviction
+  {
+    Eviction() : files( 0 ) {}
+
+    unsigned files;
+    zypp::ByteCount bytes;	//< evicted
+    zypp::ByteCount left;	//< still in the cache
+  };
+
+public:
+  /** The package cache below \a root_r (RepoManagerOptions::repoPackagesCachePath). */
+  PackageCache( const zypp::Pathname & root_r );
+
+  /** Count the packages in \a pool_r the commit is about to install as hits
+   * or misses and mark the cached ones as used. Stores the stats.
+   */
+  void commitStarts( const zypp::ResPool & pool_r );
+
+  /** Evict packages until the cache fits into \a budget_r (0 means no
+   * limit) and those not used for \a maxAgeDays_r days (0 means no limit).
+   * Packages used since \a keepSince_r are never evicted.
+   */
+  Eviction enforce( const zypp::ByteCount & budget_r, unsigned maxAgeDays_r,
+                    time_t keepSince_r = 0 );
+
+  const Stats & stats() const
+  { return _stats; }
+
+private:
+  void loadStats();
+  void saveStats() const;
+
+private:
+  zypp::Pathname _root;
+  Stats _stats;
+};
+
+#endif /* ZYPPER_PACKAGECACHE_H_ */
@@ -0,0 +1,241 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <cstring>
+
+#include <boost/format.hpp>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/PathInfo.h>
+#include <zypp/ManagedFile.h>
+#include <zypp/repo/RepoProvideFile.h>
+
+#include "main.h"
+#include "Zypper.h"
+#include "PackagePrefetcher.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  /** Runs in the worker process: get \a pkg_r to \a target_r. */
+  int fetchPackage( const Package::constPtr & pkg_r, const Pathname & target_r )
+  {
+    // the worker must neither write to the terminal nor prompt; the commit
+    // will handle any problem when downloading the package itself
+    int devnull = ::open( "/dev/null", O_RDWR );
+    if ( devnull >= 0 )
+    {
+      ::dup2( devnull, 0 );
+      ::dup2( devnull, 1 );
+      ::dup2( devnull, 2 );
+    }
+
+    try
+    {
+      repo::RepoMediaAccess access;
+      ManagedFile local( access.provideFile( pkg_r->repoInfo(), pkg_r->location() ) );
+
+      // don't let the commit see a partial file
+      Pathname tmp( target_r.extend( ".part" ) );
+      filesystem::assert_dir( target_r.dirname() );
+      if ( filesystem::hardlinkCopy( local, tmp ) == 0
+           && filesystem::rename( tmp, target_r ) == 0 )
+        return 0;
+      filesystem::unlink( tmp );
+    }
+    catch ( const Exception & e )
+    {
+      ZYPP_CAUGHT( e );
+    }
+    return 1;
+  }
+} // namespace
+
+PackagePrefetcher::PackagePrefetcher( unsigned jobs_r, const ByteCount & budget_r )
+  : _jobs( jobs_r ? jobs_r : 1 )
+  , _budget( budget_r )
+  , _next( 0 )
+  , _queued( 0 )
+  , _running( 0 )
+  , _fetched( 0 )
+{}
+
+PackagePrefetcher::~PackagePrefetcher()
+{
+  for_( it, _items.begin(), _items.end() )
+  {
+    if ( it->state == FETCHING )
+    {
+      ::kill( it->pid, SIGTERM );
+      wait( *it, 0 );
+    }
+  }
+
+  // unless the repo keeps them, the commit removes the packages it installed
+  for_( it, _items.begin(), _items.end() )
+  {
+    if ( ! it->target.empty() && ! it->pkg->repoInfo().keepPackages()
+         && ( it->state == FETCHED || it->state == FAILED ) )
+    {
+      filesystem::unlink( it->target );
+      filesystem::unlink( it->target.extend( ".part" ) );
+    }
+  }
+  MIL << "prefetched " << _fetched << " of " << _items.size() << " packages" << endl;
+}
+
+void PackagePrefetcher::start( const sat::Transaction & trans_r )
+{
+  for_( it, trans_r.begin(), trans_r.end() )
+  {
+    if ( it->stepType() != sat::Transaction::TRANSACTION_INSTALL )
+      continue;
+    Package::constPtr pkg( asKind<Package>( PoolItem( it->satSolvable() ).resolvable() ) );
+    if ( ! pkg || pkg->location().checksum().empty() )
+      continue;	// the commit accepts cached packages with a matching checksum only
+    if ( ! pkg->repoInfo().url().schemeIsDownloading() )
+      continue;	// local media, nothing to gain
+    _items.push_back( Item( pkg ) );
+    _items.back().target = pkg->repoInfo().packagesPath() / pkg->location().filename();
+  }
+  MIL << "prefetching " << _items.size() << " packages using " << _jobs << " jobs, budget " << _budget << endl;
+
+  pump();
+  if ( ! _items.empty() )
+    waitFor( 0 );
+}
+
+void PackagePrefetcher::installing( const Resolvable::constPtr & res_r )
+{
+  // the commit installs in transaction order; anything skipped in between
+  // was not one of ours
+  for ( unsigned i = _next; i < _items.size(); ++i )
+  {
+    if ( _items[i].pkg->satSolvable() != res_r->satSolvable() )
+      continue;
+    if ( _items[i].state == FETCHED && ! _items[i].target.empty() )
+      _staged -= _items[i].pkg->downloadSize();
+    if ( _items[i].state != FETCHING )
+      _items[i].state = INSTALLED;
+    _next = i + 1;
+    break;
+  }
+}
+
+void PackagePrefetcher::stepDone()
+{
+  pump();
+  // skip the ones the commit had to get itself
+  while ( _next < _items.size() && _items[_next].state == INSTALLED )
+    ++_next;
+  if ( _next < _items.size() )
+    waitFor( _next );
+}
+
+void PackagePrefetcher::pump()
+{
+  // collect finished workers (only ours, the commit runs other children)
+  for ( unsigned i = 0; _running && i < _queued; ++i )
+  {
+    if ( _items[i].state == FETCHING )
+      wait( _items[i], WNOHANG );
+  }
+
+  if ( _queued < _next )
+    _queued = _next;
+  while ( _running < _jobs && _queued < _items.size() )
+  {
+    // stay within the budget, unless nothing is staged at all
+    if ( _staged && _staged + _items[_queued].pkg->downloadSize() > _budget )
+      break;
+    launch( _queued++ );
+  }
+}
+
+void PackagePrefetcher::waitFor( unsigned idx_r )
+{
+  if ( _items[idx_r].state == QUEUED )
+  {
+    _queued = idx_r;
+    launch( _queued++ );	// needed now, regardless of the budget
+  }
+
+  if ( _items[idx_r].state == FETCHING )
+    wait( _items[idx_r], 0 );
+  pump();
+}
+
+void PackagePrefetcher::launch( unsigned idx_r )
+{
+  Item & item( _items[idx_r] );
+  if ( PathInfo( item.target ).isFile() )
+  {
+    // already in the cache (kept or downloaded before)
+    DBG << "in cache: " << item.target << endl;
+    item.state = FETCHED;
+    item.target = Pathname();	// not ours to remove
+    return;
+  }
+
+  // no buffered output must be written twice
+  cout.flush();
+  cerr.flush();
+
+  pid_t pid = ::fork();
+  if ( pid < 0 )
+  {
+    ERR << "fork: " << ::strerror( errno ) << endl;
+    item.state = FAILED;
+    return;
+  }
+  if ( pid == 0 )
+    ::_exit( fetchPackage( item.pkg, item.target ) );
+
+  DBG << "fetching " << item.pkg << " [" << pid << "]" << endl;
+  item.pid = pid;
+  item.state = FETCHING;
+  _staged += item.pkg->downloadSize();
+  ++_running;
+}
+
+void PackagePrefetcher::wait( Item & item_r, int options_r )
+{
+  int status = 0;
+  pid_t pid;
+  do
+    pid = ::waitpid( item_r.pid, &status, options_r );
+  while ( pid < 0 && errno == EINTR );
+
+  if ( pid == 0 )
+    return;	// still running (WNOHANG)
+
+  --_running;
+  if ( pid > 0 && WIFEXITED( status ) && WEXITSTATUS( status ) == 0 )
+  {
+    item_r.state = FETCHED;
+    ++_fetched;
+    Zypper::instance()->out().info( boost::str( boost::format(
+        // translators: %s-%s.%s is name-version.arch of a package
+        _("Retrieved %s-%s.%s in the background (%u/%u)") )
+        % item_r.pkg->name() % item_r.pkg->edition() % item_r.pkg->arch()
+        % _fetched % _items.size() ), Out::HIGH );
+  }
+  else
+  {
+    WAR << "failed to prefetch " << item_r.pkg << " (" << status << ")" << endl;
+    item_r.state = FAILED;
+    _staged -= item_r.pkg->downloadSize();
+  }
+}
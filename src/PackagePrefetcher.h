@@ -0,0 +1,94 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_PACKAGEPREFETCHER_H_
+#define ZYPPER_PACKAGEPREFETCHER_H_
+
+#include <vector>
+
+#include <zypp/base/NonCopyable.h>
+#include <zypp/ByteCount.h>
+#include <zypp/Package.h>
+#include <zypp/sat/Transaction.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class PackagePrefetcher
+/// \brief Fetch the packages of a commit concurrently while it installs.
+///
+/// Implements the 'pipelined' download mode. The commit itself runs in
+/// download-as-needed mode and installs the packages in transaction
+/// order. Meanwhile up to \c jobs worker processes fetch the packages to
+/// come into the repositories' package cache. There the commit finds
+/// them by checksum instead of downloading them itself.
+///
+/// The rpm callbacks drive it: \ref installing when a package's
+/// installation starts, and \ref stepDone when a transaction step
+/// finishes. stepDone() starts more workers and waits until the next
+/// package is on disk. Fetched packages which are not installed yet may
+/// not take more than \c budget bytes; the next package is always
+/// fetched, even if that exceeds the budget.
+///
+/// A package the workers fail to get is downloaded by the commit as
+/// usual, with its error handling and prompts.
+///////////////////////////////////////////////////////////////////
+class PackagePrefetcher : private zypp::base::NonCopyable
+{
+public:
+  PackagePrefetcher( unsigned jobs_r, const zypp::ByteCount & budget_r );
+
+  /** Stops running workers and removes fetched packages not installed. */
+  ~PackagePrefetcher();
+
+  /** Fetch the packages installed by the ordered transaction \a trans_r.
+   * Returns when the first one is on disk.
+   */
+  void start( const zypp::sat::Transaction & trans_r );
+
+  /** The installation of \a res_r starts. */
+  void installing( const zypp::Resolvable::constPtr & res_r );
+
+  /** A transaction step finished, the next package is needed. */
+  void stepDone();
+
+  unsigned fetched() const
+  { return _fetched; }
+
+private:
+  enum State { QUEUED, FETCHING, FETCHED, FAILED, INSTALLED };
+
+  struct Item
+  {
+    Item( const zypp::Package::constPtr & pkg_r )
+    : pkg( pkg_r ), state( QUEUED ), pid( -1 )
+    {}
+
+    zypp::Package::constPtr pkg;
+    zypp::Pathname target;	//< where the commit looks for the package
+    State state;
+    pid_t pid;
+  };
+
+  /** Start workers as the job count and the budget allow. */
+  void pump();
+  /** Wait until the item at \a idx_r is fetched or failed. */
+  void waitFor( unsigned idx_r );
+  void launch( unsigned idx_r );
+  /** Wait for the worker fetching \a item_r (\c waitpid options \a options_r). */
+  void wait( Item & item_r, int options_r );
+
+private:
+  unsigned _jobs;
+  zypp::ByteCount _budget;
+  std::vector<Item> _items;
+  unsigned _next;		//< next item the commit installs
+  unsigned _queued;		//< next item to launch
+  unsigned _running;
+  unsigned _fetched;
+  zypp::ByteCount _staged;	//< fetching or fetched, not yet installed
+};
+
+#endif /* ZYPPER_PACKAGEPREFETCHER_H_ */
@@ -0,0 +1,113 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/PathInfo.h>
+
+#include "PackageStore.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  /** Where the commit looks for \a pkg_r. */
+  inline Pathname cachePath( const Package::constPtr & pkg_r )
+  { return pkg_r->repoInfo().packagesPath() / pkg_r->location().filename(); }
+
+  /** Link (or copy) \a from_r to \a to_r, atomically. */
+  bool linkFile( const Pathname & from_r, const Pathname & to_r )
+  {
+    Pathname tmp( to_r.extend( ".part" ) );
+    filesystem::assert_dir( to_r.dirname() );
+    if ( filesystem::hardlinkCopy( from_r, tmp ) == 0
+         && filesystem::rename( tmp, to_r ) == 0 )
+      return true;
+    filesystem::unlink( tmp );
+    return false;
+  }
+} // namespace
+
+PackageStore::PackageStore( const Pathname & root_r )
+  : _root( root_r )
+  , _provided( 0 )
+  , _added( 0 )
+{}
+
+Pathname PackageStore::storePath( const CheckSum & checksum_r ) const
+{
+  const string & sum( checksum_r.checksum() );
+  return _root / checksum_r.type() / sum.substr( 0, 2 ) / ( sum + ".rpm" );
+}
+
+void PackageStore::provide( const ResPool & pool_r )
+{
+  for_( it, pool_r.byKindBegin<Package>(), pool_r.byKindEnd<Package>() )
+  {
+    if ( ! it->status().isToBeInstalled() )
+      continue;
+    Package::constPtr pkg( asKind<Package>( it->resolvable() ) );
+    if ( pkg->location().checksum().empty() )
+      continue;	// neither the store nor the commit could tell it's the same
+    if ( ! pkg->repoInfo().url().schemeIsDownloading() )
+      continue;	// nothing to download
+
+    _pending[pkg->satSolvable()] = pkg;
+
+    Pathname cached( cachePath( pkg ) );
+    if ( PathInfo( cached ).isFile() )
+      continue;
+    Pathname stored( storePath( pkg->location().checksum() ) );
+    if ( PathInfo( stored ).isFile() && linkFile( stored, cached ) )
+    {
+      DBG << "from store: " << pkg << endl;
+      ++_provided;
+    }
+  }
+  MIL << "provided " << _provided << " of " << _pending.size() << " packages from " << _root << endl;
+}
+
+void PackageStore::installing( const Resolvable::constPtr & res_r )
+{
+  map<sat::Solvable, Package::constPtr>::iterator it( _pending.find( res_r->satSolvable() ) );
+  if ( it == _pending.end() )
+    return;
+  add( it->second );
+  _pending.erase( it );
+}
+
+void PackageStore::addRemaining()
+{
+  for_( it, _pending.begin(), _pending.end() )
+    add( it->second );
+  _pending.clear();
+  MIL << "added " << _added << " packages to " << _root << endl;
+}
+
+void PackageStore::add( const Package::constPtr & pkg_r )
+{
+  Pathname cached( cachePath( pkg_r ) );
+  if ( ! PathInfo( cached ).isFile() )
+    return;	// failed or removed already
+  const CheckSum & checksum( pkg_r->location().checksum() );
+  Pathname stored( storePath( checksum ) );
+  if ( PathInfo( stored ).isFile() )
+    return;
+
+  // the store is trusted by every root, don't let a stale file in
+  if ( filesystem::checksum( cached, checksum.type() ) != checksum.checksum() )
+  {
+    WAR << "checksum mismatch, not storing " << cached << endl;
+    return;
+  }
+  if ( linkFile( cached, stored ) )
+  {
+    DBG << "stored " << pkg_r << endl;
+    ++_added;
+  }
+}
@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_PACKAGESTORE_H_
+#define ZYPPER_PACKAGESTORE_H_
+
+#include <map>
+
+#include <zypp/base/NonCopyable.h>
+#include <zypp/Pathname.h>
+#include <zypp/CheckSum.h>
+#include <zypp/Package.h>
+#include <zypp/ResPool.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class PackageStore
+/// \brief Packages stored by checksum, shared by all repositories and roots.
+///
+/// Before a commit, each package to install which is found in the store
+/// gets hardlinked into its repository's package cache, where the commit
+/// takes it instead of downloading it. When a package gets installed, its
+/// (by then verified) file gets hardlinked into the store, so the same
+/// package is never downloaded again, be it from another repository
+/// (e.g. a mirror) or for another \c --root.
+///
+/// Hardlinks need the store and the caches on the same file system,
+/// otherwise the files are copied.
+///////////////////////////////////////////////////////////////////
+class PackageStore : private zypp::base::NonCopyable
+{
+public:
+  /** The store at \a root_r (zypper.conf: cache.packagesStore). */
+  PackageStore( const zypp::Pathname & root_r );
+
+  /** Put the packages in \a pool_r the commit is about to install into
+   * their repositories' caches where the store has them.
+   */
+  void provide( const zypp::ResPool & pool_r );
+
+  /** The installation of \a res_r starts, add its file to the store. */
+  void installing( const zypp::Resolvable::constPtr & res_r );
+
+  /** Add the files of the packages not installed but still in the caches
+   * (e.g. --download-only).
+   */
+  void addRemaining();
+
+  unsigned provided() const
+  { return _provided; }
+
+  unsigned added() const
+  { return _added; }
+
+private:
+  zypp::Pathname storePath( const zypp::CheckSum & checksum_r ) const;
+  /** Add the cached file of \a pkg_r unless the store has it already. */
+  void add( const zypp::Package::constPtr & pkg_r );
+
+private:
+  zypp::Pathname _root;
+  /** packages of the commit not added yet */
+  std::map<zypp::sat::Solvable, zypp::Package::constPtr> _pending;
+  unsigned _provided;
+  unsigned _added;
+};
+
+#endif /* ZYPPER_PACKAGESTORE_H_ */
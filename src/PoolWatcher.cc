@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <sys/stat.h>
+#include <list>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/PathInfo.h>
+
+#include "PoolWatcher.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  /** Inode, size and mtime of \a path_r, empty if it does not exist. */
+  string fileState( const Pathname & path_r )
+  {
+    struct stat st;
+    if ( ::stat( path_r.c_str(), &st ) != 0 )
+      return string();
+    return str::form( "%lu:%lld:%ld.%09ld;", (unsigned long)st.st_ino, (long long)st.st_size,
+                      (long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec );
+  }
+} // namespace
+
+PoolWatcher::PoolWatcher( const Pathname & root_r, const RepoManagerOptions & options_r )
+  : _root( root_r )
+  , _options( options_r )
+{}
+
+void PoolWatcher::rememberReposConfig()
+{ _reposConfig = reposConfigState(); }
+
+bool PoolWatcher::reposConfigChanged() const
+{ return reposConfigState() != _reposConfig; }
+
+void PoolWatcher::rememberRepo( const RepoInfo & repo_r )
+{
+  string escaped( repo_r.escaped_alias() );
+  _repos[repo_r.alias()] = make_pair( escaped, repoState( escaped ) );
+}
+
+vector<string> PoolWatcher::changedRepos() const
+{
+  vector<string> ret;
+  for_( it, _repos.begin(), _repos.end() )
+  {
+    if ( repoState( it->second.first ) != it->second.second )
+      ret.push_back( it->first );
+  }
+  return ret;
+}
+
+void PoolWatcher::rememberTarget()
+{ _target = targetState(); }
+
+bool PoolWatcher::targetChanged() const
+{ return targetState() != _target; }
+
+string PoolWatcher::reposConfigState() const
+{
+  // the directory changes when files are added or removed, the files
+  // when they are edited
+  string ret( fileState( _options.knownReposPath ) );
+  list<string> files;
+  if ( filesystem::readdir( files, _options.knownReposPath, false ) == 0 )
+  {
+    files.sort();
+    for_( it, files.begin(), files.end() )
+      ret += *it + fileState( _options.knownReposPath / *it );
+  }
+  return ret;
+}
+
+string PoolWatcher::repoState( const string & escapedAlias_r ) const
+{
+  Pathname dir( _options.repoSolvCachePath / escapedAlias_r );
+  return fileState( dir / "solv" ) + fileState( dir / "cookie" );
+}
+
+string PoolWatcher::targetState() const
+{
+  // one of them, depending on the rpm version
+  Pathname dir( _root / "var/lib/rpm" );
+  return fileState( dir / "Packages" ) + fileState( dir / "Packages.db" )
+       + fileState( dir / "rpmdb.sqlite" );
+}
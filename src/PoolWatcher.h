@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_POOLWATCHER_H_
+#define ZYPPER_POOLWATCHER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <zypp/Pathname.h>
+#include <zypp/RepoInfo.h>
+#include <zypp/RepoManager.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class PoolWatcher
+/// \brief Notices changes of the files the pool was loaded from.
+///
+/// The zypper shell keeps the pool loaded across commands. Something
+/// else, or one of the commands, may meanwhile change the repository
+/// definitions in repos.d, rebuild a repository's solv cache, or change
+/// the rpm database. The loading code remembers the state of these files
+/// here, and before each command the shell asks what changed since, to
+/// reload just that (see \ref reload_changed_pool).
+///
+/// The state of a file is its inode, size and modification time in
+/// nanoseconds, so replacing it (as libzypp does with the solv files)
+/// counts as a change, too. A few stat() calls per command are cheaper
+/// than keeping inotify watches in sync with the set of repositories.
+///////////////////////////////////////////////////////////////////
+class PoolWatcher
+{
+public:
+  PoolWatcher( const zypp::Pathname & root_r, const zypp::RepoManagerOptions & options_r );
+
+  /** Remember the repository definitions (repos.d). */
+  void rememberReposConfig();
+  bool reposConfigChanged() const;
+
+  /** Remember the solv cache of \a repo_r, just loaded. */
+  void rememberRepo( const zypp::RepoInfo & repo_r );
+  /** Forget all repos, unloaded. */
+  void forgetRepos()
+  { _repos.clear(); }
+  /** Aliases of the remembered repos whose solv cache changed. */
+  std::vector<std::string> changedRepos() const;
+
+  /** Remember the rpm database, just loaded. */
+  void rememberTarget();
+  bool targetChanged() const;
+
+private:
+  std::string reposConfigState() const;
+  std::string repoState( const std::string & escapedAlias_r ) const;
+  std::string targetState() const;
+
+private:
+  zypp::Pathname _root;
+  zypp::RepoManagerOptions _options;
+
+  std::string _reposConfig;
+  /** The state of each loaded repo's solv cache, by alias. */
+  std::map<std::string, std::pair<std::string, std::string> > _repos;	//< (escaped alias, state)
+  std::string _target;
+};
+
+#endif /* ZYPPER_POOLWATCHER_H_ */
@@ -0,0 +1,90 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <unistd.h>
+#include <fstream>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+
+#include "utils/misc.h"
+#include "Profiler.h"
+
+using namespace std;
+using namespace zypp;
+
+Profiler & Profiler::instance()
+{
+  static Profiler _instance;
+  return _instance;
+}
+
+Profiler::Profiler()
+  : _enabled( true )
+  , _start( monotonic_us() )
+{}
+
+void Profiler::disable()
+{
+  _enabled = false;
+  _events.clear();
+  _open.clear();
+}
+
+void Profiler::begin( const string & name_r, const string & detail_r )
+{
+  if ( ! _enabled )
+    return;
+  Event event;
+  event.name = name_r;
+  event.detail = detail_r;
+  event.start = monotonic_us() - _start;
+  event.duration = 0;
+  _open.push_back( _events.size() );
+  _events.push_back( event );
+}
+
+void Profiler::end()
+{
+  if ( _open.empty() )
+    return;
+  Event & event( _events[_open.back()] );
+  event.duration = monotonic_us() - _start - event.start;
+  _open.pop_back();
+}
+
+bool Profiler::write( const Pathname & file_r )
+{
+  while ( ! _open.empty() )
+    end();
+
+  ofstream out( file_r.c_str() );
+  // all spans on the main thread
+  string ids( str::form( "\"pid\": %d, \"tid\": %d", int( ::getpid() ), int( ::getpid() ) ) );
+  out << "{\"traceEvents\": [" << endl;
+  out << "{\"name\": \"process_name\", \"ph\": \"M\", " << ids
+      << ", \"args\": {\"name\": \"zypper\"}}";
+  for_( it, _events.begin(), _events.end() )
+  {
+    out << "," << endl
+        << "{\"name\": \"" << json_encode( it->name ) << "\", \"cat\": \"zypper\", \"ph\": \"X\", "
+        << "\"ts\": " << it->start << ", \"dur\": " << it->duration << ", " << ids;
+    if ( ! it->detail.empty() )
+      out << ", \"args\": {\"detail\": \"" << json_encode( it->detail ) << "\"}";
+    out << "}";
+  }
+  out << endl << "], \"displayTimeUnit\": \"ms\"}" << endl;
+
+  bool ok = out.good();
+  if ( ok )
+    MIL << "wrote " << _events.size() << " spans to " << file_r << endl;
+  else
+    WAR << "can't write " << file_r << endl;
+  disable();
+  return ok;
+}
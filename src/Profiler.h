@@ -0,0 +1,78 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_PROFILER_H_
+#define ZYPPER_PROFILER_H_
+
+#include <string>
+#include <vector>
+
+#include <zypp/Pathname.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class Profiler
+/// \brief Nested, timestamped spans of the phases of a zypper run (--profile).
+///
+/// The spans are written as Chrome trace events ("complete" events),
+/// to be opened in chrome://tracing, Perfetto or the like.
+///
+/// Recording starts with the first span, before the global options are
+/// known, so that their parsing and reading the config can be measured,
+/// too. \ref Zypper::processGlobalOptions disables it unless --profile
+/// was given.
+///
+/// \code
+///   Profiler::Span span( "load repos" );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class Profiler
+{
+public:
+  static Profiler & instance();
+
+  /** Stop recording and forget the spans recorded so far. */
+  void disable();
+  bool enabled() const
+  { return _enabled; }
+
+  /** Start a span, nested in the one started last. \a detail_r is shown
+   * as its argument, e.g. the repository being loaded. */
+  void begin( const std::string & name_r, const std::string & detail_r = std::string() );
+  /** End the span started last. */
+  void end();
+
+  /** Write the spans to \a file_r, ending the open ones, and stop recording. */
+  bool write( const zypp::Pathname & file_r );
+
+  /** A span for the lifetime of the object. */
+  struct Span
+  {
+    Span( const std::string & name_r, const std::string & detail_r = std::string() )
+    { Profiler::instance().begin( name_r, detail_r ); }
+    ~Span()
+    { Profiler::instance().end(); }
+  };
+
+private:
+  Profiler();
+
+  struct Event
+  {
+    std::string name;
+    std::string detail;
+    unsigned long long start;	//< us since the profiler's start
+    unsigned long long duration;
+  };
+
+private:
+  bool _enabled;
+  unsigned long long _start;
+  std::vector<Event> _events;
+  std::vector<unsigned> _open;	//< indexes of the open spans in _events
+};
+
+#endif /* ZYPPER_PROFILER_H_ */
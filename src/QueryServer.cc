@@ -0,0 +1,344 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/base/Exception.h>
+
+#include "utils/misc.h"
+#include "QueryServer.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  /** Longest request accepted. */
+  const string::size_type max_request = 64 * 1024;
+  /** How long a client may take to send its request, in seconds. */
+  const int request_timeout = 5;
+  /** How long a client may take to read the answer, in seconds. */
+  const int reply_timeout = 30;
+
+  /** Parses the JSON subset of a request. */
+  struct Parser
+  {
+    Parser( const string & str_r )
+      : _str( str_r ), _pos( 0 )
+    {}
+
+    void skipSpace()
+    {
+      while ( _pos < _str.size() && ::strchr( " \t\r\n", _str[_pos] ) )
+        ++_pos;
+    }
+
+    bool eat( char c_r )
+    {
+      skipSpace();
+      if ( _pos < _str.size() && _str[_pos] == c_r )
+      {
+        ++_pos;
+        return true;
+      }
+      return false;
+    }
+
+    bool atEnd()
+    {
+      skipSpace();
+      return _pos == _str.size();
+    }
+
+    /** Four hex digits of a \\u escape. */
+    bool hex4( unsigned & code_r )
+    {
+      if ( _pos + 4 > _str.size() )
+        return false;
+      code_r = 0;
+      for ( unsigned i = 0; i < 4; ++i )
+      {
+        char c = _str[_pos++];
+        code_r <<= 4;
+        if ( c >= '0' && c <= '9' )
+          code_r |= c - '0';
+        else if ( c >= 'a' && c <= 'f' )
+          code_r |= c - 'a' + 10;
+        else if ( c >= 'A' && c <= 'F' )
+          code_r |= c - 'A' + 10;
+        else
+          return false;
+      }
+      return true;
+    }
+
+    static void appendUtf8( string & str_r, unsigned code_r )
+    {
+      if ( code_r < 0x80 )
+        str_r += char( code_r );
+      else if ( code_r < 0x800 )
+      {
+        str_r += char( 0xc0 | ( code_r >> 6 ) );
+        str_r += char( 0x80 | ( code_r & 0x3f ) );
+      }
+      else if ( code_r < 0x10000 )
+      {
+        str_r += char( 0xe0 | ( code_r >> 12 ) );
+        str_r += char( 0x80 | ( ( code_r >> 6 ) & 0x3f ) );
+        str_r += char( 0x80 | ( code_r & 0x3f ) );
+      }
+      else
+      {
+        str_r += char( 0xf0 | ( code_r >> 18 ) );
+        str_r += char( 0x80 | ( ( code_r >> 12 ) & 0x3f ) );
+        str_r += char( 0x80 | ( ( code_r >> 6 ) & 0x3f ) );
+        str_r += char( 0x80 | ( code_r & 0x3f ) );
+      }
+    }
+
+    bool string_( string & str_r )
+    {
+      if ( ! eat( '"' ) )
+        return false;
+      str_r.clear();
+      while ( _pos < _str.size() )
+      {
+        char c = _str[_pos++];
+        if ( c == '"' )
+          return true;
+        if ( (unsigned char)c < 0x20 )
+          return false;
+        if ( c != '\\' )
+        {
+          str_r += c;
+          continue;
+        }
+        if ( _pos == _str.size() )
+          return false;
+        switch ( _str[_pos++] )
+        {
+          case '"':  str_r += '"';  break;
+          case '\\': str_r += '\\'; break;
+          case '/':  str_r += '/';  break;
+          case 'b':  str_r += '\b'; break;
+          case 'f':  str_r += '\f'; break;
+          case 'n':  str_r += '\n'; break;
+          case 'r':  str_r += '\r'; break;
+          case 't':  str_r += '\t'; break;
+          case 'u':
+          {
+            unsigned code;
+            if ( ! hex4( code ) )
+              return false;
+            // a surrogate pair
+            if ( code >= 0xd800 && code < 0xdc00 )
+            {
+              unsigned low;
+              if ( _str.compare( _pos, 2, "\\u" ) != 0 )
+                return false;
+              _pos += 2;
+              if ( ! hex4( low ) || low < 0xdc00 || low >= 0xe000 )
+                return false;
+              code = 0x10000 + ( ( code - 0xd800 ) << 10 ) + ( low - 0xdc00 );
+            }
+            appendUtf8( str_r, code );
+            break;
+          }
+          default:
+            return false;
+        }
+      }
+      return false;
+    }
+
+    const string & _str;
+    string::size_type _pos;
+  };
+} // namespace
+
+QueryServer::QueryServer( const Pathname & socket_r )
+  : _socket( socket_r )
+  , _fd( -1 )
+  , _client( -1 )
+{
+  struct sockaddr_un addr;
+  ::memset( &addr, 0, sizeof(addr) );
+  addr.sun_family = AF_UNIX;
+  if ( _socket.asString().size() >= sizeof(addr.sun_path) )
+    ZYPP_THROW( Exception( str::form( "Socket path too long: %s", _socket.c_str() ) ) );
+  ::strcpy( addr.sun_path, _socket.c_str() );
+
+  // a socket left behind by a previous server, but nothing else
+  struct stat st;
+  if ( ::lstat( _socket.c_str(), &st ) == 0 )
+  {
+    if ( ! S_ISSOCK( st.st_mode ) )
+      ZYPP_THROW( Exception( str::form( "Not a socket: %s", _socket.c_str() ) ) );
+    ::unlink( _socket.c_str() );
+  }
+
+  // only our user may connect, from the very start
+  _fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+  mode_t saved_umask = ::umask( 0177 );
+  bool bound = ( _fd >= 0 && ::bind( _fd, (struct sockaddr *)&addr, sizeof(addr) ) == 0 );
+  ::umask( saved_umask );
+  if ( ! bound || ::listen( _fd, 16 ) != 0 )
+  {
+    string msg( str::form( "Cannot listen on %s: %s", _socket.c_str(), ::strerror( errno ) ) );
+    if ( _fd >= 0 )
+      ::close( _fd );
+    ZYPP_THROW( Exception( msg ) );
+  }
+  MIL << "listening on " << _socket << endl;
+}
+
+QueryServer::~QueryServer()
+{
+  closeClient();
+  ::close( _fd );
+  ::unlink( _socket.c_str() );
+  MIL << "closed " << _socket << endl;
+}
+
+bool QueryServer::next( vector<string> & args_r, int timeout_r )
+{
+  closeClient();
+
+  struct pollfd pfd;
+  pfd.fd = _fd;
+  pfd.events = POLLIN;
+  if ( ::poll( &pfd, 1, timeout_r ) <= 0 )
+    return false;
+
+  _client = ::accept4( _fd, NULL, NULL, SOCK_CLOEXEC );
+  if ( _client < 0 )
+  {
+    WAR << "accept: " << ::strerror( errno ) << endl;
+    return false;
+  }
+  // don't let a slow client block the others: the whole request must
+  // arrive in time, not just each piece of it
+  unsigned long long deadline = monotonic_us() + request_timeout * 1000000ULL;
+  string line;
+  char buf[4096];
+  while ( line.find( '\n' ) == string::npos && line.size() < max_request )
+  {
+    unsigned long long now = monotonic_us();
+    if ( now >= deadline )
+    {
+      WAR << "request timed out" << endl;
+      break;
+    }
+    struct pollfd cfd;
+    cfd.fd = _client;
+    cfd.events = POLLIN;
+    int ready = ::poll( &cfd, 1, int( ( deadline - now + 999 ) / 1000 ) );
+    if ( ready < 0 && errno != EINTR )
+      break;
+    if ( ready <= 0 )
+      continue;	// interrupted, or the deadline passed
+    ssize_t got = ::recv( _client, buf, sizeof(buf), MSG_DONTWAIT );
+    if ( got < 0 && ( errno == EINTR || errno == EAGAIN ) )
+      continue;
+    if ( got <= 0 )
+      break;
+    line.append( buf, got );
+  }
+  line = line.substr( 0, line.find( '\n' ) );
+
+  if ( ! parseRequest( line, args_r ) || args_r.empty() )
+  {
+    WAR << "invalid request: " << line.substr( 0, 200 ) << endl;
+    reply( 1, "", "Invalid request, expected a JSON array of strings.\n" );
+    return false;
+  }
+  DBG << "request: " << line << endl;
+  return true;
+}
+
+void QueryServer::reply( int exit_r, const string & stdout_r, const string & stderr_r )
+{
+  if ( _client < 0 )
+    return;
+
+  string answer( str::form( "{\"exit\": %d, \"stdout\": \"", exit_r ) );
+  answer += json_encode( stdout_r );
+  answer += "\", \"stderr\": \"";
+  answer += json_encode( stderr_r );
+  answer += "\"}\n";
+
+  // nor one not reading its answer
+  unsigned long long deadline = monotonic_us() + reply_timeout * 1000000ULL;
+  const char * data = answer.c_str();
+  size_t left = answer.size();
+  while ( left )
+  {
+    unsigned long long now = monotonic_us();
+    if ( now >= deadline )
+    {
+      WAR << "reply timed out, " << left << " bytes not sent" << endl;
+      break;
+    }
+    struct pollfd cfd;
+    cfd.fd = _client;
+    cfd.events = POLLOUT;
+    int ready = ::poll( &cfd, 1, int( ( deadline - now + 999 ) / 1000 ) );
+    if ( ready < 0 && errno != EINTR )
+      break;
+    if ( ready <= 0 )
+      continue;
+    ssize_t sent = ::send( _client, data, left, MSG_NOSIGNAL | MSG_DONTWAIT );
+    if ( sent < 0 && ( errno == EINTR || errno == EAGAIN ) )
+      continue;
+    if ( sent <= 0 )
+    {
+      WAR << "send: " << ::strerror( errno ) << endl;
+      break;
+    }
+    data += sent;
+    left -= sent;
+  }
+  closeClient();
+}
+
+bool QueryServer::parseRequest( const string & line_r, vector<string> & args_r )
+{
+  Parser parser( line_r );
+  args_r.clear();
+  if ( ! parser.eat( '[' ) )
+    return false;
+  if ( ! parser.eat( ']' ) )
+  {
+    do
+    {
+      string arg;
+      if ( ! parser.string_( arg ) )
+        return false;
+      args_r.push_back( arg );
+    } while ( parser.eat( ',' ) );
+    if ( ! parser.eat( ']' ) )
+      return false;
+  }
+  return parser.atEnd();
+}
+
+void QueryServer::closeClient()
+{
+  if ( _client >= 0 )
+  {
+    ::close( _client );
+    _client = -1;
+  }
+}
@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_QUERYSERVER_H_
+#define ZYPPER_QUERYSERVER_H_
+
+#include <string>
+#include <vector>
+
+#include <zypp/Pathname.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class QueryServer
+/// \brief The Unix socket of 'zypper serve'.
+///
+/// Each connection carries one request, a line with a JSON array of
+/// strings: the command and its arguments as they would be typed in
+/// the zypper shell, e.g. <tt>["search", "-s", "vim"]</tt>. The answer
+/// is a line with a JSON object, after which the connection is closed:
+/// <tt>{"exit": 0, "stdout": "...", "stderr": "..."}</tt>.
+///
+/// \ref Zypper::commandServe runs the requests one after the other
+/// on the pool it keeps loaded. A client has 5 seconds to send its
+/// request and 30 to read the answer, so a slow one can't hold up the
+/// others for longer. Only the user running the server may connect
+/// (the socket's mode is 0600).
+///////////////////////////////////////////////////////////////////
+class QueryServer
+{
+public:
+  /** Listen on \a socket_r, replacing a stale socket there.
+   * \throws zypp::Exception if the socket can't be set up.
+   */
+  QueryServer( const zypp::Pathname & socket_r );
+  /** Close and remove the socket. */
+  ~QueryServer();
+
+  /** Wait up to \a timeout_r milliseconds for the next request. Requests
+   * which are not valid are answered right away.
+   * \return whether \a args_r got a request to be answered by \ref reply.
+   */
+  bool next( std::vector<std::string> & args_r, int timeout_r );
+
+  /** Answer the current request. */
+  void reply( int exit_r, const std::string & stdout_r, const std::string & stderr_r );
+
+  /** Parse \a line_r, a JSON array of strings, into \a args_r. */
+  static bool parseRequest( const std::string & line_r, std::vector<std::string> & args_r );
+
+private:
+  void closeClient();
+
+private:
+  zypp::Pathname _socket;
+  int _fd;
+  int _client;
+};
+
+#endif /* ZYPPER_QUERYSERVER_H_ */
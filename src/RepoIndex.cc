@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <boost/lexical_cast.hpp>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+
+#include "RepoIndex.h"
+
+using namespace std;
+using namespace zypp;
+
+RepoIndex::RepoIndex( const RepoManager & manager_r )
+{
+  _repos.reserve( manager_r.repoSize() );
+  for_( it, manager_r.repoBegin(), manager_r.repoEnd() )
+  {
+    unsigned pos = _repos.size();
+    _repos.push_back( *it );
+    add( _aliases, it->alias(), pos );
+    add( _names, it->name(), pos );
+  }
+  DBG << "indexed " << _repos.size() << " repositories" << endl;
+}
+
+bool RepoIndex::find( const string & str_r, const url::ViewOption & urlview_r,
+                      RepoInfo & repo_r ) const
+{
+  // alias, number or name, the first repo having any of them
+  unsigned pos = _repos.size();
+  Positions::const_iterator it( _aliases.find( str_r ) );
+  if ( it != _aliases.end() )
+    pos = it->second;
+  it = _names.find( str_r );
+  if ( it != _names.end() )
+    pos = std::min( pos, it->second );
+  try
+  {
+    unsigned number = boost::lexical_cast<unsigned>( str_r );
+    if ( number )
+      pos = std::min( pos, number - 1 );
+  }
+  catch ( const boost::bad_lexical_cast & )
+  {}
+
+  // expensive URL analysis only if the above did not find anything
+  if ( pos >= _repos.size() )
+  {
+    try
+    {
+      const Positions & urls( urlPositions( urlview_r ) );
+      it = urls.find( urlKey( Url( str_r ), urlview_r ) );
+      if ( it != urls.end() )
+        pos = it->second;
+    }
+    catch ( const url::UrlException & )
+    {}
+  }
+
+  if ( pos >= _repos.size() )
+    return false;
+  repo_r = _repos[pos];
+  return true;
+}
+
+url::ViewOption RepoIndex::urlView( bool looseAuth_r, bool looseQuery_r )
+{
+  url::ViewOption ret( url::ViewOption::DEFAULTS + url::ViewOption::WITH_PASSWORD );
+  if ( looseAuth_r )
+    ret = ret - url::ViewOptions::WITH_PASSWORD - url::ViewOptions::WITH_USERNAME;
+  if ( looseQuery_r )
+    ret = ret - url::ViewOptions::WITH_QUERY_STR;
+  return ret;
+}
+
+string RepoIndex::urlKey( Url url_r, const url::ViewOption & urlview_r )
+{
+  // we expect repo urls to be directories, and servers and operating
+  // systems to accept their paths with and without trailing slashes
+  url_r.setPathName( Pathname( url_r.getPathName() ).asString() );
+
+  // Need to do asString(urlview) comparison if the user-given string is
+  // expected to have no credentials or query, otherwise compare like
+  // Url::operator== does.
+  if ( urlview_r.has( url::ViewOptions::WITH_PASSWORD )
+       && urlview_r.has( url::ViewOptions::WITH_QUERY_STR ) )
+    return url_r.asCompleteString();
+  return url_r.asString( urlview_r );
+}
+
+const RepoIndex::Positions & RepoIndex::urlPositions( const url::ViewOption & urlview_r ) const
+{
+  Positions & ret( _urls[urlview_r.getOptions()] );
+  if ( ! ret.empty() )
+    return ret;
+
+  for ( unsigned pos = 0; pos < _repos.size(); ++pos )
+  {
+    for_( urlit, _repos[pos].baseUrlsBegin(), _repos[pos].baseUrlsEnd() )
+    {
+      try
+      {
+        add( ret, urlKey( *urlit, urlview_r ), pos );
+      }
+      catch ( const url::UrlException & )
+      {}
+    }
+  }
+  DBG << ret.size() << " URL keys for view " << urlview_r.getOptions() << endl;
+  return ret;
+}
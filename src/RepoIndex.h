@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_REPOINDEX_H_
+#define ZYPPER_REPOINDEX_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <zypp/RepoInfo.h>
+#include <zypp/RepoManager.h>
+#include <zypp/Url.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class RepoIndex
+/// \brief Lookup of the known repositories by alias, number, name or URL.
+///
+/// Built once from a RepoManager's repositories, so that matching many
+/// command line arguments does not scan all repositories for each of them
+/// (see \ref match_repo). Like the scan, if several repositories match,
+/// the first one in the RepoManager's order wins.
+///
+/// The URL keys are the repositories' base URLs without a trailing slash
+/// in the path (bnc #585082), rendered with the view option used for the
+/// comparison (see \ref urlView). They are computed the first time a
+/// view is asked for, as this is the expensive part.
+///
+/// \ref Zypper::repoIndex keeps one for its RepoManager and drops it when
+/// the repositories change.
+///////////////////////////////////////////////////////////////////
+class RepoIndex
+{
+public:
+  RepoIndex( const zypp::RepoManager & manager_r );
+
+  /** Find the repo whose alias, number or name is \a str_r, and failing
+   * that, the one with the URL \a str_r compared as \a urlview_r.
+   */
+  bool find( const std::string & str_r, const zypp::url::ViewOption & urlview_r,
+             zypp::RepoInfo & repo_r ) const;
+
+  /** Number of repositories indexed. */
+  unsigned size() const
+  { return _repos.size(); }
+
+  /** The view option for comparing URLs, leaving out the credentials
+   * if \a looseAuth_r, and the query if \a looseQuery_r.
+   */
+  static zypp::url::ViewOption urlView( bool looseAuth_r, bool looseQuery_r );
+
+private:
+  typedef std::unordered_map<std::string, unsigned> Positions;
+
+  /** The key of \a url_r (normalized) compared as \a urlview_r. */
+  static std::string urlKey( zypp::Url url_r, const zypp::url::ViewOption & urlview_r );
+
+  /** The URL keys for \a urlview_r, computed on first use. */
+  const Positions & urlPositions( const zypp::url::ViewOption & urlview_r ) const;
+
+  /** Remember \a key_r for the repo at \a pos_r, unless an earlier one has it. */
+  static void add( Positions & positions_r, const std::string & key_r, unsigned pos_r )
+  { positions_r.insert( std::make_pair( key_r, pos_r ) ); }
+
+private:
+  std::vector<zypp::RepoInfo> _repos;
+  Positions _aliases;
+  Positions _names;
+  mutable std::unordered_map<int, Positions> _urls;	//< by view option
+};
+
+#endif /* ZYPPER_REPOINDEX_H_ */
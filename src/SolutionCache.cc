@@ -0,0 +1,380 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <fstream>
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/Digest.h>
+#include <zypp/PathInfo.h>
+#include <zypp/ZConfig.h>
+#include <zypp/ZYppFactory.h>
+#include <zypp/Resolver.h>
+#include <zypp/Patch.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/WhatProvides.h>
+
+#include "SolutionCache.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  SolutionCache::Step asStep( const PoolItem & pi_r )
+  {
+    SolutionCache::Step ret;
+    ret.install = ! pi_r.status().isInstalled();
+    ret.kind = pi_r->kind().asString();
+    ret.name = pi_r->name();
+    ret.edition = pi_r->edition().asString();
+    ret.arch = pi_r->arch().asString();
+    ret.repo = pi_r->repoInfo().alias();
+    return ret;
+  }
+
+  /** The pool item \a step_r is about. */
+  PoolItem findItem( const ResPool & pool_r, const SolutionCache::Step & step_r )
+  {
+    for_( it, pool_r.byIdentBegin( ResKind( step_r.kind ), step_r.name ),
+              pool_r.byIdentEnd( ResKind( step_r.kind ), step_r.name ) )
+    {
+      if ( (*it)->edition().asString() == step_r.edition
+           && (*it)->arch().asString() == step_r.arch
+           && (*it)->repoInfo().alias() == step_r.repo )
+        return *it;
+    }
+    return PoolItem();
+  }
+
+  /** Feeds strings to a digest, NUL terminated so they can't run together. */
+  struct Fingerprint
+  {
+    Fingerprint()
+    { _digest.create( Digest::sha1() ); }
+
+    void add( const string & str_r )
+    { _digest.update( str_r.c_str(), str_r.size() + 1 ); }
+
+    /** Sorted, as the order must not matter. */
+    void add( vector<string> & strs_r )
+    {
+      std::sort( strs_r.begin(), strs_r.end() );
+      for_( it, strs_r.begin(), strs_r.end() )
+        add( *it );
+      add( "" );
+    }
+
+    string digest()
+    { return _digest.digest(); }
+
+    Digest _digest;
+  };
+} // namespace
+
+string SolutionCache::Step::asString() const
+{
+  return str::form( "%c\t%s\t%s\t%s\t%s\t%s", install ? '+' : '-',
+                    kind.c_str(), name.c_str(), edition.c_str(), arch.c_str(), repo.c_str() );
+}
+
+SolutionCache::SolutionCache( const Pathname & dir_r )
+  : _dir( dir_r )
+{}
+
+string SolutionCache::fingerprint( const ResPool & pool_r, const string & request_r )
+{
+  Fingerprint ret;
+  const ZConfig & zconfig( ZConfig::instance() );
+  ret.add( zconfig.systemArchitecture().asString() );
+  ret.add( request_r );
+
+  // the resolver's settings, as zypp.conf, zypper.conf and the command
+  // line made them
+  Resolver_Ptr resolver( getZYpp()->resolver() );
+  ret.add( str::form( "forceResolve=%d onlyRequires=%d ignoreAlreadyRecommended=%d"
+                      " allowVendorChange=%d cleandepsOnRemove=%d"
+                      " dupAllowDowngrade=%d dupAllowNameChange=%d"
+                      " dupAllowArchChange=%d dupAllowVendorChange=%d",
+                      resolver->forceResolve(),
+                      resolver->onlyRequires(),
+                      resolver->ignoreAlreadyRecommended(),
+                      resolver->allowVendorChange(),
+                      resolver->cleandepsOnRemove(),
+                      resolver->dupAllowDowngrade(),
+                      resolver->dupAllowNameChange(),
+                      resolver->dupAllowArchChange(),
+                      resolver->dupAllowVendorChange() ) );
+  // packages which may be installed in several versions
+  set<string> multiversion( zconfig.multiversionSpec() );
+  vector<string> lines( multiversion.begin(), multiversion.end() );
+  ret.add( lines );
+
+  const sat::Pool & satpool( sat::Pool::instance() );
+  lines.clear();
+  for_( repo, satpool.reposBegin(), satpool.reposEnd() )
+  {
+    if ( repo->isSystemRepo() )
+      continue;
+    lines.push_back( str::form( "%s %u %ld %u", repo->alias().c_str(),
+                                unsigned( repo->solvablesSize() ),
+                                long( repo->generatedTimestamp() ),
+                                repo->info().priority() ) );
+  }
+  ret.add( lines );
+
+  lines.clear();
+  Repository system( satpool.findSystemRepo() );
+  if ( system != Repository::noRepository )
+  {
+    for_( it, system.solvablesBegin(), system.solvablesEnd() )
+      lines.push_back( it->ident().asString() + "-" + it->edition().asString() + "." + it->arch().asString() );
+  }
+  ret.add( lines );
+
+  // the request: what the user or application wants, and the locks
+  lines.clear();
+  for_( it, pool_r.begin(), pool_r.end() )
+  {
+    const ResStatus & status( it->status() );
+    if ( status.transacts() && ! status.isBySolver() )
+      lines.push_back( asStep( *it ).asString() );
+    if ( status.isLocked() )
+      lines.push_back( "L" + asStep( *it ).asString() );
+  }
+  ret.add( lines );
+
+  return ret.digest();
+}
+
+bool SolutionCache::load( const string & fingerprint_r, Steps & steps_r ) const
+{
+  ifstream in( entryPath( fingerprint_r ).c_str() );
+  if ( ! in )
+    return false;
+
+  steps_r.clear();
+  string line;
+  while ( getline( in, line ) )
+  {
+    vector<string> fields;
+    str::split( line, back_inserter( fields ), "\t" );
+    if ( fields.size() != 6 || fields[0].size() != 1 )
+    {
+      WAR << "invalid line in " << entryPath( fingerprint_r ) << ": " << line << endl;
+      return false;
+    }
+    Step step;
+    step.install = ( fields[0] == "+" );
+    step.kind = fields[1];
+    step.name = fields[2];
+    step.edition = fields[3];
+    step.arch = fields[4];
+    step.repo = fields[5];
+    steps_r.push_back( step );
+  }
+  return true;
+}
+
+void SolutionCache::store( const string & fingerprint_r, const ResPool & pool_r ) const
+{
+  Pathname file( entryPath( fingerprint_r ) );
+  Pathname tmp( file.extend( ".new" ) );
+  filesystem::assert_dir( _dir );
+  {
+    ofstream out( tmp.c_str() );
+    Steps steps( transaction( pool_r ) );
+    for_( it, steps.begin(), steps.end() )
+      out << it->asString() << endl;
+    if ( ! out )
+    {
+      WAR << "can't write " << tmp << endl;
+      filesystem::unlink( tmp );
+      return;
+    }
+  }
+  filesystem::rename( tmp, file );
+  DBG << "stored solution " << fingerprint_r << endl;
+}
+
+bool SolutionCache::apply( const string & fingerprint_r, const ResPool & pool_r,
+                           string & reason_r ) const
+{
+  Steps steps;
+  if ( ! load( fingerprint_r, steps ) )
+  {
+    reason_r = "no cached solution";
+    return false;
+  }
+
+  vector<PoolItem> items;
+  set<pair<string,string> > installed;	// (kind, name) of the installed steps
+  for_( it, steps.begin(), steps.end() )
+  {
+    PoolItem pi( findItem( pool_r, *it ) );
+    if ( ! pi || pi.status().isInstalled() == it->install )
+    {
+      reason_r = "not in the pool: " + it->asString();
+      return false;
+    }
+    items.push_back( pi );
+    if ( it->install )
+      installed.insert( make_pair( it->kind, it->name ) );
+  }
+
+  // everything requested must be part of it
+  for_( it, pool_r.begin(), pool_r.end() )
+  {
+    if ( it->status().transacts() && ! it->status().isBySolver()
+         && std::find( items.begin(), items.end(), *it ) == items.end() )
+    {
+      reason_r = "request not covered: " + asStep( *it ).asString();
+      return false;
+    }
+  }
+
+  vector<PoolItem> changed;
+  bool ok = true;
+  for ( unsigned i = 0; ok && i < items.size(); ++i )
+  {
+    ResStatus & status( items[i].status() );
+    if ( status.transacts() )
+      continue;
+    if ( steps[i].install )
+      ok = status.setToBeInstalled( ResStatus::SOLVER );
+    else if ( installed.count( make_pair( steps[i].kind, steps[i].name ) ) )
+      ok = status.setToBeUninstalledDueToUpgrade( ResStatus::SOLVER );
+    else
+      ok = status.setToBeUninstalled( ResStatus::SOLVER );
+    if ( ok )
+      changed.push_back( items[i] );
+    else
+      reason_r = "can't set the status: " + steps[i].asString();
+  }
+
+  if ( ok && validate( pool_r, reason_r ) )
+  {
+    MIL << "applied cached solution " << fingerprint_r << " (" << steps.size() << " steps)" << endl;
+    return true;
+  }
+
+  for_( it, changed.begin(), changed.end() )
+    it->status().resetTransact( ResStatus::SOLVER );
+  return false;
+}
+
+SolutionCache::Steps SolutionCache::transaction( const ResPool & pool_r )
+{
+  Steps ret;
+  for_( it, pool_r.begin(), pool_r.end() )
+  {
+    if ( it->status().transacts() )
+      ret.push_back( asStep( *it ) );
+  }
+  return ret;
+}
+
+bool SolutionCache::validate( const ResPool & pool_r, string & reason_r )
+{
+  // the solvables installed after the transaction, and the new ones
+  unordered_set<sat::detail::IdType> after;
+  vector<sat::Solvable> added;
+  for_( it, pool_r.begin(), pool_r.end() )
+  {
+    if ( it->isKind<Patch>() )
+      continue;	// no real solvables
+    const ResStatus & status( it->status() );
+    if ( status.isInstalled() ? ! status.isToBeUninstalled() : status.isToBeInstalled() )
+    {
+      after.insert( it->satSolvable().id() );
+      if ( ! status.isInstalled() )
+        added.push_back( it->satSolvable() );
+    }
+  }
+  auto inAfter = [&]( const sat::Solvable & solv_r ) { return after.count( solv_r.id() ) != 0; };
+
+  for_( id, after.begin(), after.end() )
+  {
+    sat::Solvable solv( *id );
+    bool isNew = ! solv.isSystem();
+
+    // requirements: no new ones unmet, none met before broken
+    Capabilities requires( solv.requires() );
+    for_( cap, requires.begin(), requires.end() )
+    {
+      if ( str::hasPrefix( cap->c_str(), "rpmlib(" ) )
+        continue;
+      sat::WhatProvides providers( *cap );
+      bool met = false;
+      bool metBefore = false;
+      for_( prv, providers.begin(), providers.end() )
+      {
+        if ( inAfter( *prv ) )
+        {
+          met = true;
+          break;
+        }
+        if ( prv->isSystem() )
+          metBefore = true;
+      }
+      if ( ! met && ( isNew || metBefore ) )
+      {
+        reason_r = solv.asString() + " requires " + cap->asString();
+        return false;
+      }
+    }
+
+    // conflicts involving anything new
+    Capabilities conflicts( solv.conflicts() );
+    for_( cap, conflicts.begin(), conflicts.end() )
+    {
+      sat::WhatProvides providers( *cap );
+      for_( prv, providers.begin(), providers.end() )
+      {
+        if ( *prv != solv && inAfter( *prv ) && ( isNew || ! prv->isSystem() ) )
+        {
+          reason_r = solv.asString() + " conflicts with " + prv->asString();
+          return false;
+        }
+      }
+    }
+  }
+
+  // what the new ones replace must be gone
+  for_( it, added.begin(), added.end() )
+  {
+    Capabilities obsoletes( it->obsoletes() );
+    for_( cap, obsoletes.begin(), obsoletes.end() )
+    {
+      sat::WhatProvides providers( *cap );
+      for_( prv, providers.begin(), providers.end() )
+      {
+        if ( prv->isSystem() && inAfter( *prv ) && prv->ident() == cap->detail().name() )
+        {
+          reason_r = it->asString() + " obsoletes " + prv->asString();
+          return false;
+        }
+      }
+    }
+
+    if ( it->multiversionInstall() )
+      continue;
+    for_( pi, pool_r.byIdentBegin( it->ident() ), pool_r.byIdentEnd( it->ident() ) )
+    {
+      if ( pi->satSolvable().isSystem() && inAfter( pi->satSolvable() ) )
+      {
+        reason_r = it->asString() + " does not replace " + pi->satSolvable().asString();
+        return false;
+      }
+    }
+  }
+  return true;
+}
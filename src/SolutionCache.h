@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_SOLUTIONCACHE_H_
+#define ZYPPER_SOLUTIONCACHE_H_
+
+#include <string>
+#include <vector>
+
+#include <zypp/Pathname.h>
+#include <zypp/ResPool.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class SolutionCache
+/// \brief Solver results kept by a fingerprint of the pool and the request.
+///
+/// The fingerprint covers the system architecture, the resolver's settings
+/// (as set up for the command from zypp.conf, zypper.conf and the command
+/// line), the multiversion packages, each repository's alias, size,
+/// metadata timestamp and priority, the installed packages (not their
+/// order, which differs from rpmdb to rpmdb), the requested transactions
+/// and locks, and the command line. Hosts with identical repositories, settings and installed systems
+/// asking for the same get the same fingerprint and can share a cache
+/// directory.
+///
+/// A cached solution is applied by setting the pool status of its steps,
+/// and used only if the resulting system is consistent: new packages'
+/// requirements are met, nothing satisfied before breaks, and no
+/// conflicts or obsoleted packages remain. This is much cheaper than
+/// solving, and guards against the fingerprint missing something.
+///////////////////////////////////////////////////////////////////
+class SolutionCache
+{
+public:
+  /** A step of a transaction, what sat::Transaction would do. */
+  struct Step
+  {
+    bool install;	//< or remove
+    std::string kind;
+    std::string name;
+    std::string edition;
+    std::string arch;
+    std::string repo;	//< alias
+
+    std::string asString() const;
+  };
+  typedef std::vector<Step> Steps;
+
+public:
+  /** The cache in \a dir_r (zypper.conf: solver.solutionCache). */
+  SolutionCache( const zypp::Pathname & dir_r );
+
+  /** Fingerprint of \a pool_r's content and request, the resolver's
+   * settings, and \a request_r (the command line). Computed before
+   * solving, after the resolver was set up for the command.
+   */
+  static std::string fingerprint( const zypp::ResPool & pool_r, const std::string & request_r );
+
+  /** The cached steps for \a fingerprint_r, false if there are none. */
+  bool load( const std::string & fingerprint_r, Steps & steps_r ) const;
+
+  /** Remember the transaction in \a pool_r (as solved) for \a fingerprint_r. */
+  void store( const std::string & fingerprint_r, const zypp::ResPool & pool_r ) const;
+
+  /** Apply the cached solution for \a fingerprint_r to \a pool_r, if there
+   * is one and it is valid. Otherwise \a pool_r stays unchanged and
+   * \a reason_r tells why.
+   */
+  bool apply( const std::string & fingerprint_r, const zypp::ResPool & pool_r,
+              std::string & reason_r ) const;
+
+  zypp::Pathname entryPath( const std::string & fingerprint_r ) const
+  { return _dir / ( fingerprint_r + ".solution" ); }
+
+  /** The transaction in \a pool_r. */
+  static Steps transaction( const zypp::ResPool & pool_r );
+
+  /** Whether the transaction in \a pool_r leaves a consistent system. */
+  static bool validate( const zypp::ResPool & pool_r, std::string & reason_r );
+
+private:
+  zypp::Pathname _dir;
+};
+
+#endif /* ZYPPER_SOLUTIONCACHE_H_ */
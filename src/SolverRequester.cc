@@ -10,6 +10,8 @@
  *
  */
 
+#include <algorithm>
+
 #include <zypp/ZYppFactory.h>
 #include <zypp/base/LogTools.h>
 
@@ -22,6 +24,7 @@
 #include <zypp/ui/Selectable.h>
 
 #include "misc.h"
+#include "update.h"
 
 #include "SolverRequester.h"
 
@@ -35,6 +38,25 @@ using namespace std;
 using namespace zypp;
 using namespace zypp::ui;
 
+namespace
+{
+  /**
+   * Whether \a pkg is just a name, with no version, arch, repo, or glob.
+   * All the rest needs a PoolQuery.
+   */
+  bool is_plain_name(const PackageSpec & pkg)
+  {
+    const CapDetail & detail(pkg.parsed_cap.detail());
+    return pkg.repo_alias.empty()
+        && detail.isSimple() && !detail.isVersioned() && !detail.hasArch()
+        && detail.name().asString().find_first_of("*?[") == string::npos;
+  }
+
+  /** Key of the SolverRequester name index (PoolQuery ignores case, too). */
+  string name_key(const ResKind & kind, const string & name)
+  { return kind.asString() + ":" + str::toLower(name); }
+}
+
 
 /////////////////////////////////////////////////////////////////////////
 // SolverRequester::Options
@@ -91,6 +113,7 @@ void SolverRequester::installRemove(const PackageArgs & args)
   if (args.empty())
     return;
 
+  indexNames(args.dos());
   for_(it, args.dos().begin(), args.dos().end())
     install(*it);
 
@@ -99,8 +122,59 @@ void SolverRequester::installRemove(const PackageArgs & args)
   //   $ zypper install pattern:lamp_sever -someunwantedpackage
   // and similar nice things.
 
+  indexNames(args.donts());
   for_(it, args.donts().begin(), args.donts().end())
     remove(*it);
+
+  // the index is only good as long as the pool does not change
+  indexNames(PackageArgs::PackageSpecSet());
+}
+
+// ----------------------------------------------------------------------------
+
+void SolverRequester::indexNames(const PackageArgs::PackageSpecSet & specs)
+{
+  _by_name.clear();
+  _indexed_kinds.clear();
+
+  ResKindSet kinds;
+  unsigned plain = 0;
+  for_(it, specs.begin(), specs.end())
+  {
+    if (is_plain_name(*it))
+    {
+      ++plain;
+      kinds.insert(sat::Solvable::SplitIdent(it->parsed_cap.detail().name()).kind());
+    }
+  }
+  // below this, a PoolQuery for each is cheaper than a pass over the pool
+  if (plain < bulk_threshold)
+    return;
+
+  ResPool pool(ResPool::instance());
+  for_(kind, kinds.begin(), kinds.end())
+  {
+    for_(it, pool.byKindBegin(*kind), pool.byKindEnd(*kind))
+      _by_name[name_key(*kind, (*it)->name())].push_back(*it);
+  }
+  _indexed_kinds = kinds;
+  DBG << "indexed " << _by_name.size() << " names for " << plain << " arguments" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+const vector<PoolItem> * SolverRequester::lookupName(const PackageSpec & pkg) const
+{
+  static const vector<PoolItem> none;
+
+  if (_indexed_kinds.empty() || !is_plain_name(pkg))
+    return 0;
+  sat::Solvable::SplitIdent splid(pkg.parsed_cap.detail().name());
+  if (!_indexed_kinds.count(splid.kind()))
+    return 0;
+
+  auto found(_by_name.find(name_key(splid.kind(), splid.name().asString())));
+  return found == _by_name.end() ? &none : &found->second;
 }
 
 // ----------------------------------------------------------------------------
@@ -139,14 +213,27 @@ void SolverRequester::install(const PackageSpec & pkg)
 
   if (!_opts.force_by_cap)
   {
-    PoolQuery q = pkg_spec_to_poolquery(pkg.parsed_cap, _opts.from_repos);
-    if (!pkg.repo_alias.empty())
-      q.addRepo(pkg.repo_alias);
-
     // get the best matching items and tag them for installation.
     // FIXME this ignores vendor lock - we need some way to do --from which
     // would respect vendor lock: e.g. a new Selectable::updateCandidateObj(Options&)
-    PoolItemBest bestMatches(q.begin(), q.end());
+    PoolItemBest bestMatches;
+    if (const vector<PoolItem> * named = lookupName(pkg))
+    {
+      for_(it, named->begin(), named->end())
+      {
+        if (_opts.from_repos.empty()
+            || find(_opts.from_repos.begin(), _opts.from_repos.end(),
+                    (*it)->repoInfo().alias()) != _opts.from_repos.end())
+          bestMatches.add(*it);
+      }
+    }
+    else
+    {
+      PoolQuery q = pkg_spec_to_poolquery(pkg.parsed_cap, _opts.from_repos);
+      if (!pkg.repo_alias.empty())
+        q.addRepo(pkg.repo_alias);
+      bestMatches = PoolItemBest(q.begin(), q.end());
+    }
     if (!bestMatches.empty())
     {
       for_(sit, bestMatches.begin(), bestMatches.end())
@@ -255,12 +342,19 @@ void SolverRequester::remove(const PackageSpec & pkg)
 
   if (!_opts.force_by_cap)
   {
-    PoolQuery q = pkg_spec_to_poolquery(pkg.parsed_cap, "");
+    vector<PoolItem> matches;
+    if (const vector<PoolItem> * named = lookupName(pkg))
+      matches = *named;
+    else
+    {
+      PoolQuery q = pkg_spec_to_poolquery(pkg.parsed_cap, "");
+      matches.assign(q.poolItemBegin(), q.poolItemEnd());
+    }
 
-    if (!q.empty())
+    if (!matches.empty())
     {
       bool got_installed = false;
-      for_(it, q.poolItemBegin(), q.poolItemEnd())
+      for_(it, matches.begin(), matches.end())
       {
         if (it->status().isInstalled())
         {
@@ -326,8 +420,10 @@ void SolverRequester::update(const PackageArgs & args)
 
   _command = ZypperCommand::UPDATE;
 
+  indexNames(args.dos());
   for_(it, args.dos().begin(), args.dos().end())
     install(*it);
+  indexNames(PackageArgs::PackageSpecSet());
 
   /* TODO Solve and unmark dont which are setToBeInstalled in the pool?
   for_(it, args.donts().begin(), args.donts().end())
@@ -348,19 +444,28 @@ void SolverRequester::updatePatches()
 {
   DBG << "going to mark needed patches for installation" << endl;
 
-  // search twice: if there are none with restartSuggested(), retry on all
-  // (in the first run, ignore_pkgmgmt == 0, in the second it is 1)
+  // only the needed patches can be installed, see installPatch()
+  const UpdateCandidates::Patches & patches(needed_patches(*Zypper::instance()));
+
+  // mark those with restartSuggested() first, and only if there are none,
+  // all of them (in the first run, ignore_pkgmgmt == 0, in the second it is 1)
   bool any_marked = false;
   for (unsigned ignore_pkgmgmt = 0;
        !any_marked && ignore_pkgmgmt < 2; ++ignore_pkgmgmt)
   {
-    for_(it, zypp::getZYpp()->pool().proxy().byKindBegin(ResKind::patch),
-             zypp::getZYpp()->pool().proxy().byKindEnd  (ResKind::patch))
+    const vector<PoolItem> & candidates(
+        ignore_pkgmgmt ? patches.needed : patches.pkgManager);
+    set<Selectable::Ptr> done;
+    for_(it, candidates.begin(), candidates.end())
     {
+      Selectable::Ptr s(asSelectable()(*it));
+      if (!done.insert(s).second)
+        continue;
+
       PackageSpec patch;
-      patch.orig_str = (*it)->name();
-      patch.parsed_cap = Capability((*it)->name());
-      if (installPatch(patch, (*it)->candidateObj(), ignore_pkgmgmt))
+      patch.orig_str = s->name();
+      patch.parsed_cap = Capability(s->name());
+      if (installPatch(patch, s->candidateObj(), ignore_pkgmgmt))
         any_marked = true;
     }
 
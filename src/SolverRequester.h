@@ -14,6 +14,8 @@
 #define SOLVERREQUESTER_H_
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 #include <zypp/ZConfig.h>
 #include <zypp/Date.h>
@@ -247,6 +249,13 @@ public:
     : _opts(opts), _command(ZypperCommand::NONE)
   {}
 
+  /**
+   * Number of plain package names (no version, arch, repo, or glob) in
+   * the arguments from which on they are looked up in a name index built
+   * in one pass over the pool, instead of running a PoolQuery for each.
+   */
+  static const unsigned bulk_threshold = 10;
+
 public:
   /** Request installation of specified objects. */
   void install(const PackageArgs & args);
@@ -305,6 +314,18 @@ public:
 private:
   void installRemove(const PackageArgs & args);
 
+  /**
+   * Index the pool items of the kinds of the plain names in \a specs
+   * by name, if there are at least \ref bulk_threshold of them.
+   */
+  void indexNames(const PackageArgs::PackageSpecSet & specs);
+
+  /**
+   * The pool items named like \a pkg if it is a plain name of an indexed
+   * kind, like a PoolQuery would find them (ignoring case), or 0.
+   */
+  const std::vector<zypp::PoolItem> * lookupName(const PackageSpec & pkg) const;
+
   /**
    * Requests installation or update to the best of objects available in repos
    * according to specified arguments and options.
@@ -399,6 +420,10 @@ private:
   std::set<zypp::PoolItem> _toremove;
   std::set<zypp::Capability> _requires;
   std::set<zypp::Capability> _conflicts;
+
+  /** Pool items by kind and lowercase name, see \ref indexNames. */
+  std::unordered_map<std::string, std::vector<zypp::PoolItem> > _by_name;
+  ResKindSet _indexed_kinds;
 };
 
 #endif /* SOLVERREQUESTER_H_ */
@@ -8,11 +8,13 @@
 #include <string.h>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <boost/format.hpp>
 
 #include <zypp/ZYppFactory.h>
 #include <zypp/base/LogTools.h>
-#include <zypp/base/Measure.h>
 #include <zypp/ResPool.h>
 #include <zypp/Patch.h>
 #include <zypp/Package.h>
@@ -24,6 +26,7 @@
 #include "utils/misc.h"
 #include "Table.h"
 #include "Zypper.h"
+#include "UpdateCandidates.h"
 
 #include "Summary.h"
 
@@ -50,6 +53,7 @@ Summary::Summary(const zypp::ResPool & pool, const ViewOptions options)
   , _wrap_width(80)
   , _force_no_color(false)
   , _download_only(false)
+  , _weakdeps_collected(false)
 {
   readPool(pool);
 }
@@ -72,6 +76,32 @@ typedef std::map<
   zypp::Resolvable::Kind,
   std::set<zypp::ResObject::constPtr, ResNameCompare> > KindToResObjectSet;
 
+/** (kind, name) ident to the resolvables of that name in ResNameCompare order. */
+typedef std::unordered_map<
+  zypp::sat::detail::IdType,
+  std::vector<zypp::ResObject::constPtr> > IdentToResObjects;
+
+/** Records the duration of consecutive steps. */
+class StepTimer
+{
+public:
+  StepTimer(Summary::Timings & timings_r)
+    : _timings(timings_r), _start(monotonic_us())
+  { _timings.clear(); }
+
+  void step(const char * name_r)
+  {
+    unsigned long long now = monotonic_us();
+    _timings.push_back(make_pair(string(name_r), now - _start));
+    DBG << "readPool " << name_r << ": " << (now - _start) << "us" << endl;
+    _start = now;
+  }
+
+private:
+  Summary::Timings & _timings;
+  unsigned long long _start;
+};
+
 // --------------------------------------------------------------------------
 
 void Summary::readPool(const zypp::ResPool & pool)
@@ -104,7 +134,7 @@ void Summary::readPool(const zypp::ResPool & pool)
   MIL << "Pool contains " << pool.size() << " items." << std::endl;
   DBG << "Install summary:" << endl;
 
-  debug::Measure m;
+  StepTimer timer(_timings);
 
   for (ResPool::const_iterator it = pool.begin(); it != pool.end(); ++it)
   {
@@ -141,7 +171,7 @@ void Summary::readPool(const zypp::ResPool & pool)
     to_be_installed[ResKind::package].size() +
     to_be_installed[ResKind::srcpackage].size();
 
-  m.elapsed();
+  timer.step("collect");
 
 /* This will work again after commit refactoring: all the srcpackages will be in the pool
 
@@ -150,6 +180,17 @@ void Summary::readPool(const zypp::ResPool & pool)
     _toinstall[ResKind::srcpackage].insert(*it);
 */
 
+  // index to_be_removed by (kind, name) so pairing the to_be_installed with
+  // their removed counterparts does not need to scan all of to_be_removed
+  IdentToResObjects removed_by_ident;
+  for (KindToResObjectSet::const_iterator it = to_be_removed.begin();
+      it != to_be_removed.end(); ++it)
+    for (set<ResObject::constPtr>::const_iterator resit = it->second.begin();
+        resit != it->second.end(); ++resit)
+      removed_by_ident[(*resit)->ident().id()].push_back(*resit);
+
+  timer.step("index");
+
   // iterate the to_be_installed to find installs/upgrades/downgrades + size info
 
   ResObject::constPtr nullres;
@@ -173,10 +214,12 @@ void Summary::readPool(const zypp::ResPool & pool)
 
       // find in to_be_removed:
       bool upgrade_downgrade = false;
-      for (set<ResObject::constPtr>::iterator rmit = to_be_removed[res->kind()].begin();
-          rmit != to_be_removed[res->kind()].end(); ++rmit)
+      IdentToResObjects::iterator idxit = removed_by_ident.find(res->ident().id());
+      if (idxit != removed_by_ident.end())
       {
-        if (res->name() == (*rmit)->name())
+        vector<ResObject::constPtr> & samename(idxit->second);
+        for (vector<ResObject::constPtr>::iterator rmit = samename.begin();
+            rmit != samename.end(); ++rmit)
         {
           ResPair rp(*rmit, res);
 
@@ -223,6 +266,7 @@ void Summary::readPool(const zypp::ResPool & pool)
 
           // this turned out to be an upgrade/downgrade
           to_be_removed[res->kind()].erase(*rmit);
+          samename.erase(rmit);
           upgrade_downgrade = true;
           break;
         }
@@ -238,7 +282,7 @@ void Summary::readPool(const zypp::ResPool & pool)
     }
   }
 
-  m.elapsed();
+  timer.step("pair");
 
   // collect the rest (not upgraded/downgraded) of to_be_removed as '_toremove'
   // and decrease installed size change accordingly
@@ -260,7 +304,7 @@ void Summary::readPool(const zypp::ResPool & pool)
       _inst_size_change -= (*resit)->installSize();
     }
 
-  m.elapsed();
+  timer.step("remove");
 
   // *** notupdated ***
 
@@ -272,32 +316,21 @@ void Summary::readPool(const zypp::ResPool & pool)
   kinds.insert(ResKind::product);
   for_(kit, kinds.begin(), kinds.end())
   {
-    for_(it, pool.proxy().byKindBegin(*kit), pool.proxy().byKindEnd(*kit))
+    const UpdateCandidates::Candidates & available(
+        UpdateCandidates::instance().candidates(*kit));
+    for_(it, available.begin(), available.end())
     {
-      if (!(*it)->hasInstalledObj())
-        continue;
-
-      ResObject::constPtr candidate =
-        (*it)->highestAvailableVersionObj().resolvable();
-
-      if (!candidate)
-        continue;
-      if (compareByNVRA((*it)->installedObj().resolvable(), candidate) >= 0)
-        continue;
       // ignore higher versions with different arch (except noarch) bnc #646410
-      if ((*it)->installedObj()->arch() != candidate->arch()
-          && (*it)->installedObj()->arch() != Arch_noarch
-          && candidate->arch() != Arch_noarch)
+      if (it->changesArch())
         continue;
       // mutliversion packages do not end up in _toupgrade, so we need to remove
       // them from candidates if the candidate actually installs (bnc #629197)
-      if (multi_installed.find(candidate->name()) != multi_installed.end()
-          && candidate->poolItem().status().isToBeInstalled())
+      if (multi_installed.find(it->candidate->name()) != multi_installed.end()
+          && it->candidate.status().isToBeInstalled())
         continue;
 
-      candidates[*kit].insert(ResPair(nullres, candidate));
+      candidates[*kit].insert(ResPair(nullres, it->candidate.resolvable()));
     }
-    MIL << *kit << " update candidates: " << candidates[*kit].size() << endl;
     MIL << "to be actually updated: " << _toupgrade[*kit].size() << endl;
   }
 
@@ -330,7 +363,7 @@ void Summary::readPool(const zypp::ResPool & pool)
       ++it;
   }
 
-  m.stop();
+  timer.step("notupdated");
 }
 
 // --------------------------------------------------------------------------
@@ -646,67 +679,151 @@ void Summary::writeReinstalled(ostream & out)
 
 // --------------------------------------------------------------------------
 
-void Summary::collectInstalledRecommends(const ResObject::constPtr & obj)
+///////////////////////////////////////////////////////////////////
+/// \class Summary::WeakDeps
+/// \brief Memoized capability and solvable lookups for the weak deps info.
+///
+/// The pool does not change while the summary is shown, so each
+/// capability is looked up only once, no matter how many packages of
+/// the transaction share it.
+///////////////////////////////////////////////////////////////////
+class Summary::WeakDeps
 {
-  XXX << obj << endl;
-  ResObject::constPtr nullres;
-
-  Capabilities rec = obj->recommends();
-  for_(capit, rec.begin(), rec.end())
+public:
+  /** A provider and its matching pair in _toinstall. */
+  typedef std::pair<sat::Solvable, const ResPair *> Provider;
+  typedef std::vector<Provider> Providers;
+  typedef std::vector<ui::Selectable::Ptr> Selectables;
+
+  WeakDeps(const KindToResPairSet & toinstall_r)
+    : _toinstall(toinstall_r)
+  {}
+
+  /** Not-system providers of \a cap_r (in WhatProvides order) which match
+   * an object in _toinstall (the ones selected by the solver). */
+  const Providers & toInstallProviders(const Capability & cap_r)
   {
-    sat::WhatProvides q(*capit);
-    // not using selectables here: matching found resolvables against those
-    // in the _toinstall set (the ones selected by the solver)
+    std::unordered_map<sat::detail::IdType, Providers>::iterator it =
+      _providers.find(cap_r.id());
+    if (it != _providers.end())
+      return it->second;
+
+    Providers & ret(_providers[cap_r.id()]);
+    sat::WhatProvides q(cap_r);
     for_(sit, q.begin(), q.end())
     {
       if (sit->isSystem()) // is it necessary to have the system solvable?
         continue;
-      if (sit->name() == obj->name())
-        continue; // ignore self-recommends (should not happen, though)
+      const ResPair * match = toInstallMatch(*sit);
+      if (match)
+        ret.push_back(Provider(*sit, match));
+    }
+    return ret;
+  }
 
-      XXX << "rec: " << *sit << endl;
-      ResObject::constPtr recobj = makeResObject(*sit);
+  /** Selectables providing \a cap_r. */
+  const Selectables & providingSelectables(const Capability & cap_r)
+  {
+    std::unordered_map<sat::detail::IdType, Selectables>::iterator it =
+      _selectables.find(cap_r.id());
+    if (it != _selectables.end())
+      return it->second;
+
+    Selectables & ret(_selectables[cap_r.id()]);
+    sat::WhatProvides q(cap_r);
+    ret.assign(q.selectableBegin(), q.selectableEnd());
+    return ret;
+  }
+
+  /** Whether the deps of \a solv_r were completely walked already. */
+  bool walked(const sat::Solvable & solv_r) const
+  { return _walked.count(solv_r.id()); }
+
+  void setWalked(const sat::Solvable & solv_r)
+  { _walked.insert(solv_r.id()); }
+
+private:
+  const ResPair * toInstallMatch(const sat::Solvable & solv_r)
+  {
+    std::unordered_map<sat::detail::IdType, const ResPair *>::iterator it =
+      _matches.find(solv_r.id());
+    if (it != _matches.end())
+      return it->second;
+
+    const ResPair * ret = 0;
+    KindToResPairSet::const_iterator kit = _toinstall.find(solv_r.kind());
+    if (kit != _toinstall.end())
+    {
       ResPairSet::const_iterator match =
-        _toinstall[sit->kind()].find(ResPair(nullres, recobj));
-      if (match != _toinstall[sit->kind()].end())
-      {
-        if (_recommended[sit->kind()].insert(*match).second)
-          collectInstalledRecommends(recobj);
-        break;
-      }
+        kit->second.find(ResPair(ResObject::constPtr(), makeResObject(solv_r)));
+      if (match != kit->second.end())
+        ret = &*match;
+    }
+    _matches[solv_r.id()] = ret;
+    return ret;
+  }
+
+private:
+  const KindToResPairSet & _toinstall;
+  std::unordered_map<sat::detail::IdType, Providers> _providers;
+  std::unordered_map<sat::detail::IdType, Selectables> _selectables;
+  std::unordered_map<sat::detail::IdType, const ResPair *> _matches;
+  std::unordered_set<sat::detail::IdType> _walked;
+};
+
+// --------------------------------------------------------------------------
+
+void Summary::collectInstalledRecommends(WeakDeps & deps, const sat::Solvable & solv)
+{
+  // Walking a solvable again after its walk completed would not find
+  // anything new. Walks still in progress (dependency cycles) are repeated
+  // as before, to keep the result unchanged.
+  if (deps.walked(solv))
+    return;
+  XXX << solv << endl;
+
+  Capabilities rec = solv.recommends();
+  for_(capit, rec.begin(), rec.end())
+  {
+    const WeakDeps::Providers & providers(deps.toInstallProviders(*capit));
+    for_(pit, providers.begin(), providers.end())
+    {
+      if (pit->first.name() == solv.name())
+        continue; // ignore self-recommends (should not happen, though)
+
+      XXX << "rec: " << pit->first << endl;
+      if (_recommended[pit->first.kind()].insert(*pit->second).second)
+        collectInstalledRecommends(deps, pit->first);
+      break;
     }
   }
 
-  Capabilities req = obj->requires();
+  Capabilities req = solv.requires();
   for_(capit, req.begin(), req.end())
   {
-    sat::WhatProvides q(*capit);
-    for_(sit, q.begin(), q.end())
+    const WeakDeps::Providers & providers(deps.toInstallProviders(*capit));
+    for_(pit, providers.begin(), providers.end())
     {
-      if (sit->isSystem()) // is it necessary to have the system solvable?
-        continue;
-      if (sit->name() == obj->name())
+      if (pit->first.name() == solv.name())
         continue; // ignore self-requires
-      XXX << "req: " << *sit << endl;
-      ResObject::constPtr reqobj = makeResObject(*sit);
-      ResPairSet::const_iterator match =
-        _toinstall[sit->kind()].find(ResPair(nullres, reqobj));
-      if (match != _toinstall[sit->kind()].end())
-      {
-        if (_required[sit->kind()].insert(*match).second)
-          collectInstalledRecommends(reqobj);
-        break;
-      }
+
+      XXX << "req: " << pit->first << endl;
+      if (_required[pit->first.kind()].insert(*pit->second).second)
+        collectInstalledRecommends(deps, pit->first);
+      break;
     }
   }
+
+  deps.setWalked(solv);
 }
 
 // --------------------------------------------------------------------------
 
-static void collectNotInstalledDeps(
+void Summary::collectNotInstalledDeps(
+    WeakDeps & deps,
     const Dep & dep,
     const ResObject::constPtr & obj,
-    Summary::KindToResPairSet & result)
+    KindToResPairSet & result)
 {
   static std::vector<ui::Selectable::Ptr> tmp;	// reuse capacity
   //DBG << obj << endl;
@@ -714,8 +831,8 @@ static void collectNotInstalledDeps(
   for_( capit, req.begin(), req.end() )
   {
     tmp.clear();
-    sat::WhatProvides q(*capit);
-    for_( it, q.selectableBegin(), q.selectableEnd() )
+    const WeakDeps::Selectables & providers( deps.providingSelectables(*capit) );
+    for_( it, providers.begin(), providers.end() )
     {
       if ( (*it)->name() == obj->name() )
         continue;		// ignore self-deps
@@ -739,7 +856,7 @@ static void collectNotInstalledDeps(
       for_( it, tmp.begin(), tmp.end() )
       {
 	//DBG << dep << " :" << (*it)->onSystem() << ": " << dump(*(*it)) << endl;
-	result[(*it)->kind()].insert(Summary::ResPair(nullptr, (*it)->candidateObj()));
+	result[(*it)->kind()].insert(ResPair(nullptr, (*it)->candidateObj()));
       }
     }
   }
@@ -747,28 +864,34 @@ static void collectNotInstalledDeps(
 
 // --------------------------------------------------------------------------
 
-void Summary::writeRecommended(ostream & out)
+void Summary::collectWeakDeps()
 {
-  // lazy-compute the installed recommended objects
-  if (_recommended.empty())
-  {
-    ResObject::constPtr obj;
-    for_(kindit, _toinstall.begin(), _toinstall.end())
-      for_(it, kindit->second.begin(), kindit->second.end())
-        // collect recommends of all packages request by user
-        if (it->second->poolItem().status().getTransactByValue() != ResStatus::SOLVER)
-          collectInstalledRecommends(it->second);
-  }
+  if (_weakdeps_collected)
+    return;
+  _weakdeps_collected = true;
 
-  // lazy-compute the not-to-be-installed recommended objects
-  if (_noinstrec.empty())
-  {
-    ResObject::constPtr obj;
-    for_(kindit, _toinstall.begin(), _toinstall.end())
-      for_(it, kindit->second.begin(), kindit->second.end())
-        if (it->second->poolItem().status().getTransactByValue() != ResStatus::SOLVER)
-          collectNotInstalledDeps(Dep::RECOMMENDS, it->second, _noinstrec);
-  }
+  // one pass over the objects requested by the user, sharing the lookups
+  WeakDeps deps(_toinstall);
+  for_(kindit, _toinstall.begin(), _toinstall.end())
+    for_(it, kindit->second.begin(), kindit->second.end())
+    {
+      if (it->second->poolItem().status().getTransactByValue() == ResStatus::SOLVER)
+        continue;
+
+      // the installed recommended objects
+      collectInstalledRecommends(deps, it->second->satSolvable());
+      // the not-to-be-installed recommended and suggested objects
+      collectNotInstalledDeps(deps, Dep::RECOMMENDS, it->second, _noinstrec);
+      collectNotInstalledDeps(deps, Dep::SUGGESTS, it->second, _noinstsug);
+    }
+}
+
+// --------------------------------------------------------------------------
+
+void Summary::writeRecommended(ostream & out)
+{
+  // lazy-compute the recommended objects
+  collectWeakDeps();
 
   for_(it, _recommended.begin(), _recommended.end())
   {
@@ -893,15 +1016,8 @@ void Summary::writeRecommended(ostream & out)
 
 void Summary::writeSuggested(ostream & out)
 {
-  if (_noinstsug.empty())
-  {
-    ResObject::constPtr obj;
-    for_(kindit, _toinstall.begin(), _toinstall.end())
-      for_(it, kindit->second.begin(), kindit->second.end())
-        // collect recommends of all packages request by user
-        if (it->second->poolItem().status().getTransactByValue() != ResStatus::SOLVER)
-          collectNotInstalledDeps(Dep::SUGGESTS, it->second, _noinstsug);
-  }
+  // lazy-compute the suggested objects
+  collectWeakDeps();
 
   for_(it, _noinstsug.begin(), _noinstsug.end())
   {
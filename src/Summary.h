@@ -10,6 +10,8 @@
 
 #include <set>
 #include <map>
+#include <vector>
+#include <string>
 #include <iosfwd>
 
 #include <zypp/base/PtrTypes.h>
@@ -29,6 +31,8 @@ public:
   };
   typedef std::set<ResPair, ResPairNameCompare> ResPairSet;
   typedef std::map<zypp::ResKind, ResPairSet> KindToResPairSet;
+  /** Time spent in the steps of reading the pool (step name, microseconds). */
+  typedef std::vector<std::pair<std::string, unsigned long long> > Timings;
 
   enum _view_options
   {
@@ -104,6 +108,9 @@ public:
   bool needPkgMgrRestart() const
   { return _need_restart; }
 
+  const Timings & timings() const
+  { return _timings; }
+
 
   void dumpTo(std::ostream & out);
   void dumpAsXmlTo(std::ostream & out);
@@ -113,7 +120,13 @@ private:
   void writeResolvableList(std::ostream & out, const ResPairSet & resolvables);
   void writeXmlResolvableList(std::ostream & out, const KindToResPairSet & resolvables);
 
-  void collectInstalledRecommends(const zypp::ResObject::constPtr & obj);
+  class WeakDeps;
+  void collectWeakDeps();
+  void collectInstalledRecommends(WeakDeps & deps, const zypp::sat::Solvable & solv);
+  static void collectNotInstalledDeps(WeakDeps & deps,
+                                      const zypp::Dep & dep,
+                                      const zypp::ResObject::constPtr & obj,
+                                      KindToResPairSet & result);
 
 private:
   ViewOptions _viewop;
@@ -151,10 +164,13 @@ private:
   /** names of packages which have multiple versions (to-be-)installed */
   std::set<std::string> multi_installed;
 
+  Timings _timings;
+
 
   /** \name For weak deps info.
    * @{
    */
+  bool _weakdeps_collected;
   KindToResPairSet _required;
   KindToResPairSet _recommended;
   //! recommended but not to be installed
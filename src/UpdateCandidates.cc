@@ -0,0 +1,113 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/ResPool.h>
+#include <zypp/Patch.h>
+
+#include "utils/misc.h"
+#include "UpdateCandidates.h"
+
+using namespace std;
+using namespace zypp;
+
+bool UpdateCandidates::Candidate::changesArch() const
+{
+  return installed->arch() != candidate->arch()
+      && installed->arch() != Arch_noarch
+      && candidate->arch() != Arch_noarch;
+}
+
+UpdateCandidates & UpdateCandidates::instance()
+{
+  static UpdateCandidates _instance;
+  return _instance;
+}
+
+void UpdateCandidates::checkPoolSerial()
+{
+  if ( _poolSerial.remember( ResPool::instance().serial() ) )
+  {
+    DBG << "pool changed, dropping cached update candidates" << endl;
+    _candidates.clear();
+    _patches.reset();
+  }
+}
+
+const UpdateCandidates::Candidates & UpdateCandidates::candidates( const ResKind & kind_r )
+{
+  const ResPool & pool( ResPool::instance() );
+  checkPoolSerial();
+
+  std::map<ResKind, Candidates>::iterator it( _candidates.find( kind_r ) );
+  if ( it != _candidates.end() )
+    return it->second;
+
+  Candidates & ret( _candidates[kind_r] );
+  // get all available updates, no matter if they are installable or break
+  // some current policy
+  for_( sit, pool.proxy().byKindBegin( kind_r ), pool.proxy().byKindEnd( kind_r ) )
+  {
+    if ( ! (*sit)->hasInstalledObj() )
+      continue;
+
+    PoolItem candidate( (*sit)->highestAvailableVersionObj() ); // bnc #557557
+    if ( ! candidate )
+      continue;
+    PoolItem installed( (*sit)->installedObj() );
+    if ( compareByNVRA( installed.resolvable(), candidate.resolvable() ) >= 0 )
+      continue;
+
+    Candidate c;
+    c.selectable = *sit;
+    c.installed = installed;
+    c.candidate = candidate;
+    ret.push_back( c );
+  }
+  MIL << kind_r << " update candidates: " << ret.size() << endl;
+  return ret;
+}
+
+UpdateCandidates::PatchCounts UpdateCandidates::Patches::counts() const
+{
+  PatchCounts ret;
+  ret.needed = needed.size();
+  ret.security = security.size();
+  ret.affectsPkgManager = pkgManager.size();
+  return ret;
+}
+
+const UpdateCandidates::Patches & UpdateCandidates::patches()
+{
+  checkPoolSerial();
+  if ( _patches )
+    return *_patches;
+
+  unsigned long long start = monotonic_us();
+  _patches.reset( new Patches );
+  Patches & ret( *_patches );
+  const ResPool & pool( ResPool::instance() );
+  for_( it, pool.byKindBegin( ResKind::patch ), pool.byKindEnd( ResKind::patch ) )
+  {
+    ++ret.total;
+    if ( ! it->isBroken() )
+      continue;	// the vast majority: satisfied or not relevant
+
+    Patch::constPtr patch( asKind<Patch>( it->resolvable() ) );
+    ret.needed.push_back( *it );
+    if ( patch->categoryEnum() == Patch::CAT_SECURITY )
+      ret.security.push_back( *it );
+    if ( patch->restartSuggested() )
+      ret.pkgManager.push_back( *it );
+  }
+  ret.time_us = monotonic_us() - start;
+  MIL << "patches: " << ret.total << ", needed: " << ret.needed.size()
+      << ", security: " << ret.security.size() << ", package manager: " << ret.pkgManager.size()
+      << " (" << ret.time_us << " us)" << endl;
+  return ret;
+}
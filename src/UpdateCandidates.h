@@ -0,0 +1,109 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UPDATECANDIDATES_H_
+#define ZYPPER_UPDATECANDIDATES_H_
+
+#include <map>
+#include <vector>
+
+#include <zypp/base/PtrTypes.h>
+#include <zypp/base/SerialNumber.h>
+#include <zypp/ResKind.h>
+#include <zypp/PoolItem.h>
+#include <zypp/ui/Selectable.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class UpdateCandidates
+/// \brief Available updates of the installed objects.
+///
+/// For each installed selectable the highest available version, if it
+/// is newer than the installed one. This depends on the pool content
+/// only, so it is computed once per kind and kept until the pool's
+/// serial number changes. Shared by list-updates and the summary's
+/// list of not updated packages.
+///
+/// Likewise the needed patches, indexed by status in one pass over the
+/// pool's patches for patch, patch-check and list-patches, which then
+/// only look at those. As the patch status is established by the
+/// resolver, \ref patchStatusChanged must be called after it ran.
+///////////////////////////////////////////////////////////////////
+class UpdateCandidates
+{
+public:
+  struct Candidate
+  {
+    zypp::ui::Selectable::Ptr selectable;
+    zypp::PoolItem installed;
+    zypp::PoolItem candidate;
+
+    /** Whether the candidate has a different arch than the installed
+     * object and none of them is noarch (bnc #646410). */
+    bool changesArch() const;
+  };
+  typedef std::vector<Candidate> Candidates;
+
+  /** Counts of patches which are relevant but not yet satisfied. */
+  struct PatchCounts
+  {
+    PatchCounts() : needed( 0 ), security( 0 ), affectsPkgManager( 0 ) {}
+
+    unsigned needed;
+    unsigned security;
+    /** Needed patches which update the package manager itself. */
+    unsigned affectsPkgManager;
+  };
+
+  /** The patches which are relevant but not yet satisfied, by status. */
+  struct Patches
+  {
+    Patches() : total( 0 ), time_us( 0 ) {}
+
+    /** All needed patches, in the order of the pool. */
+    std::vector<zypp::PoolItem> needed;
+    /** The needed ones which update the package manager itself. */
+    std::vector<zypp::PoolItem> pkgManager;
+    /** The needed security patches. */
+    std::vector<zypp::PoolItem> security;
+
+    /** Number of patches in the pool. */
+    unsigned total;
+    /** Time it took to build the index. */
+    unsigned long long time_us;
+
+    PatchCounts counts() const;
+  };
+
+public:
+  static UpdateCandidates & instance();
+
+  /** Update candidates of \a kind_r in the order of the pool proxy. */
+  const Candidates & candidates( const zypp::ResKind & kind_r );
+
+  /** The needed patches, indexed on first use. */
+  const Patches & patches();
+
+  /** Count the needed patches. */
+  PatchCounts patchCounts()
+  { return patches().counts(); }
+
+  /** Drop the patch index, after the resolver ran. */
+  void patchStatusChanged()
+  { _patches.reset(); }
+
+private:
+  UpdateCandidates() {}
+
+  /** Drop everything if the pool changed. */
+  void checkPoolSerial();
+
+  zypp::SerialNumberWatcher _poolSerial;
+  std::map<zypp::ResKind, Candidates> _candidates;
+  zypp::shared_ptr<Patches> _patches;
+};
+
+#endif /* ZYPPER_UPDATECANDIDATES_H_ */
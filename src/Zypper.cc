@@ -40,7 +40,12 @@
 #include "main.h"
 #include "Zypper.h"
 #include "Command.h"
+#include "PoolWatcher.h"
+#include "Profiler.h"
+#include "QueryServer.h"
+#include "RepoIndex.h"
 #include "SolverRequester.h"
+#include "UpdateCandidates.h"
 
 #include "Table.h"
 #include "utils/misc.h"
@@ -103,9 +108,11 @@ int Zypper::main(int argc, char ** argv)
 {
   _argc = argc;
   _argv = argv;
+  Profiler::Span span("zypper");
 
   // parse global options and the command
   try {
+    Profiler::Span span("global options");
     processGlobalOptions();
   }
   catch (const ExitRequestException & e)
@@ -127,6 +134,11 @@ int Zypper::main(int argc, char ** argv)
     cleanup();
     return exitCode();
 
+  case ZypperCommand::SERVE_e:
+    commandServe();
+    cleanup();
+    return exitCode();
+
   case ZypperCommand::NONE_e:
     return ZYPPER_EXIT_ERR_SYNTAX;
 
@@ -150,6 +162,15 @@ Out & Zypper::out()
   ZYPP_THROW(ExitRequestException("no output writer"));
 }
 
+const RepoIndex & Zypper::repoIndex()
+{
+  // the size check catches changes made behind our back, e.g. by services
+  RepoManager & manager( repoManager() );
+  if (!_repo_index || _repo_index->size() != manager.repoSize())
+    _repo_index.reset(new RepoIndex(manager));
+  return *_repo_index;
+}
+
 
 void print_main_help(Zypper & zypper)
 {
@@ -172,6 +193,9 @@ void print_main_help(Zypper & zypper)
     "\t\t\t\tthe rebootSuggested-flag set.\n"
     "\t--xmlout, -x\t\tSwitch to XML output.\n"
     "\t--ignore-unknown, -i\tIgnore unknown packages.\n"
+    "\t--timings\t\tReport time spent in the individual steps.\n"
+    "\t--solver-stats\t\tReport time and size of the solver runs.\n"
+    "\t--profile <file>\tWrite a trace of the phases of the run to <file>.\n"
   );
 
   static string repo_manager_options = _(
@@ -204,6 +228,7 @@ void print_main_help(Zypper & zypper)
     "  Commands:\n"
     "\thelp, ?\t\t\tPrint help.\n"
     "\tshell, sh\t\tAccept multiple commands at once.\n"
+    "\tserve\t\t\tAnswer queries sent to a Unix socket.\n"
   );
 
   static string help_repo_commands = _("     Repository Management:\n"
@@ -315,8 +340,38 @@ void print_command_help_hint(Zypper & zypper)
       % (zypper.runningShell() ? "help <command>" : "zypper help <command>")));
 }
 
+/** Whether the package types given by --type are all source packages,
+ * which are never installed. */
+static bool only_srcpackages_requested()
+{
+  parsed_opts::const_iterator it = copts.find("type");
+  if (it == copts.end() || it->second.empty())
+    return false;
+  for_(type, it->second.begin(), it->second.end())
+    if (string_to_kind(*type) != ResKind::srcpackage)
+      return false;
+  return true;
+}
+
+Zypper::LoadSystemFlags Zypper::commandLoadFlags() const
+{
+  LoadSystemFlags ret;
+  switch (command().toEnum())
+  {
+  // the status of source packages is always 'not installed'
+  case ZypperCommand::SEARCH_e:
+  case ZypperCommand::INFO_e:
+    if (only_srcpackages_requested())
+      ret |= NO_TARGET;
+    break;
+  default:;
+  }
+  return ret;
+}
+
 int Zypper::defaultLoadSystem( LoadSystemFlags flags_r )
 {
+  flags_r |= commandLoadFlags();
   DBG << "FLAGS:" << flags_r << endl;
   if ( ! flags_r.testFlag( NO_POOL ) )
   {
@@ -398,6 +453,9 @@ void Zypper::processGlobalOptions()
     {"config",                     required_argument, 0, 'c'},
     {"userdata",                   required_argument, 0,  0 },
     {"ignore-unknown",             no_argument,       0, 'i'},
+    {"timings",                    no_argument,       0,  0 },
+    {"solver-stats",               no_argument,       0,  0 },
+    {"profile",                    required_argument, 0,  0 },
     {0, 0, 0, 0}
   };
 
@@ -411,9 +469,18 @@ void Zypper::processGlobalOptions()
 
   parsed_opts::const_iterator it;
 
+  // keep recording the phases of this run only if asked to
+  if ((it = gopts.find("profile")) != gopts.end())
+    _gopts.profile = it->second.front();
+  else
+    Profiler::instance().disable();
+
   // read config from specified file or default config files
-  _config.read(
-      (it = gopts.find("config")) != gopts.end() ? it->second.front() : "");
+  {
+    Profiler::Span span("read config");
+    _config.read(
+        (it = gopts.find("config")) != gopts.end() ? it->second.front() : "");
+  }
 
   // ====== output setup ======
   // depends on global options, that's we set it up here
@@ -784,6 +851,12 @@ void Zypper::processGlobalOptions()
   if (gopts.count("ignore-unknown"))
     _gopts.ignore_unknown = true;
 
+  if (gopts.count("timings"))
+    _gopts.timings = true;
+
+  if (gopts.count("solver-stats"))
+    _gopts.solver_stats = true;
+
   MIL << "DONE" << endl;
 }
 
@@ -796,6 +869,7 @@ void Zypper::commandShell()
 
   God = zypp::getZYpp();
   init_target( *this );
+  _rdata.pool_watcher.reset( new PoolWatcher( _gopts.root_dir, _gopts.rm_options ) );
 
   string histfile;
   try {
@@ -834,8 +908,8 @@ void Zypper::commandShell()
 
     try
     {
-      MIL << "Reloading..." << endl;
-      God->target()->reload();   // reload system in case rpm database has changed
+      // reload what changed since the previous command
+      reload_changed_pool(*this);
       setCommand(ZypperCommand(command_str));
       if (command() == ZypperCommand::SHELL_QUIT)
         break;
@@ -860,6 +934,125 @@ void Zypper::commandShell()
   setRunningShell(false);
 }
 
+/** Whether 'zypper serve' answers \a command, one which does not change the system. */
+static bool is_served_command(const ZypperCommand & command)
+{
+  switch (command.toEnum())
+  {
+  case ZypperCommand::HELP_e:
+  case ZypperCommand::SEARCH_e:
+  case ZypperCommand::INFO_e:
+  case ZypperCommand::WHAT_PROVIDES_e:
+  case ZypperCommand::PACKAGES_e:
+  case ZypperCommand::PATCHES_e:
+  case ZypperCommand::PATTERNS_e:
+  case ZypperCommand::PRODUCTS_e:
+  case ZypperCommand::LIST_UPDATES_e:
+  case ZypperCommand::LIST_PATCHES_e:
+  case ZypperCommand::PATCH_CHECK_e:
+  case ZypperCommand::LIST_REPOS_e:
+  case ZypperCommand::LIST_SERVICES_e:
+  case ZypperCommand::LIST_LOCKS_e:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void Zypper::commandServe()
+{
+  MIL << "Entering the server" << endl;
+
+  processCommandOptions();
+  if (runningHelp())
+  {
+    out().info(_command_help, Out::QUIET);
+    return;
+  }
+  if (exitCode())
+    return;
+  if (!copts.count("socket"))
+  {
+    report_required_arg_missing(out(), _command_help);
+    setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+    return;
+  }
+
+  shared_ptr<QueryServer> server;
+  try
+  {
+    server.reset(new QueryServer(copts["socket"].front()));
+  }
+  catch (const Exception & e)
+  {
+    ZYPP_CAUGHT(e);
+    out().error(e.asUserString());
+    setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+    return;
+  }
+
+  // Queries only: nothing gets refreshed and nobody is asked, and the zypp
+  // lock is left to the commands changing the system, run as usual.
+  _gopts.non_interactive = true;
+  _gopts.no_refresh = true;
+  zypp_readonly_hack::IWantIt();
+  God = zypp::getZYpp();
+  init_target( *this );
+  _rdata.pool_watcher.reset( new PoolWatcher( _gopts.root_dir, _gopts.rm_options ) );
+
+  out().info(str::form(_("Serving queries on %s."), copts["socket"].front().c_str()));
+  // the shell's way to take the commands and keep the pool
+  setRunningShell(true);
+  shellCleanup();
+
+  vector<string> request;
+  while (!exitRequested())
+  {
+    if (!server->next(request, 1000))
+      continue;
+
+    std::ostringstream request_out;
+    std::ostringstream request_err;
+    std::streambuf * saved_out = cout.rdbuf(request_out.rdbuf());
+    std::streambuf * saved_err = cerr.rdbuf(request_err.rdbuf());
+
+    Args args(request);
+    optind = 0;
+    _sh_argc = args.argc();
+    _sh_argv = args.argv();
+    try
+    {
+      setCommand(ZypperCommand(request.front()));
+      if (!is_served_command(command()))
+      {
+        out().error(str::form(
+          _("'%s' is not served, run it as 'zypper %s' instead."),
+          request.front().c_str(), request.front().c_str()));
+        setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      }
+      else
+      {
+        // reload what changed since the previous request
+        reload_changed_pool(*this);
+        safeDoCommand();
+      }
+    }
+    catch (const Exception & e)
+    {
+      out().error(e.msg());
+      setExitCode(ZYPPER_EXIT_ERR_SYNTAX);
+    }
+
+    cout.rdbuf(saved_out);
+    cerr.rdbuf(saved_err);
+    server->reply(exitCode(), request_out.str(), request_err.str());
+    shellCleanup();
+  }
+
+  MIL << "Leaving the server" << endl;
+  setRunningShell(false);
+}
+
 void Zypper::shellCleanup()
 {
   MIL << "Cleaning up for the next command." << endl;
@@ -896,12 +1089,10 @@ void Zypper::shellCleanup()
 
   // cause the RepoManager to be reinitialized
   _rm.reset();
+  _repo_index.reset();
 
-  // TODO:
-  // _rdata.repos re-read after repo operations or modify/remove these very repoinfos
-  // _rdata.repo_resolvables re-read only after certain repo operations (all?)
-  // _rdata.target_resolvables re-read only after installation/removal/update
-  // call target commit refresh pool after installation/removal/update (#328855)
+  // _rdata.repos and the pool stay loaded, the next command reloads what
+  // changed meanwhile (see reload_changed_pool())
 }
 
 
@@ -909,9 +1100,13 @@ void Zypper::shellCleanup()
 // catch unexpected exceptions and tell the user to report a bug (#224216)
 void Zypper::safeDoCommand()
 {
+  Profiler::Span span("command", command().asString());
   try
   {
-    processCommandOptions();
+    {
+      Profiler::Span span("command options");
+      processCommandOptions();
+    }
     if (command() == ZypperCommand::NONE || exitCode())
       return;
 
@@ -1015,6 +1210,7 @@ void Zypper::processCommandOptions()
       // rug compatibility option, we have --repo
       {"catalog",                   required_argument, 0, 'c'},
       {"from",                      required_argument, 0,  0 },
+      {"from-file",                 required_argument, 0,  0 },
       {"type",                      required_argument, 0, 't'},
       // the default (ignored)
       {"name",                      no_argument,       0, 'n'},
@@ -1064,6 +1260,9 @@ void Zypper::processCommandOptions()
       "                            Default: %s.\n"
       "-n, --name                  Select packages by plain name, not by capability.\n"
       "-C, --capability            Select packages by capability.\n"
+      "    --from-file <file>      Read the packages from the file, one per line\n"
+      "                            ('-' for standard input, with\n"
+      "                            --non-interactive).\n"
       "-f, --force                 Install even if the item is already installed (reinstall),\n"
       "                            downgraded or changes vendor or architecture.\n"
       "    --oldpackage            Allow to replace a newer item with an older one.\n"
@@ -1087,7 +1286,7 @@ void Zypper::processCommandOptions()
       "-d, --download-only         Only download the packages, do not install.\n"
     ), "package, patch, pattern, product, srcpackage",
        "package",
-       "only, in-advance, in-heaps, as-needed");
+       "only, in-advance, in-heaps, as-needed, pipelined");
     break;
   }
 
@@ -1098,6 +1297,7 @@ void Zypper::processCommandOptions()
       // rug compatibility option, we have --repo
       {"catalog",    required_argument, 0, 'c'},
       {"type",       required_argument, 0, 't'},
+      {"from-file",  required_argument, 0,  0 },
       // the default (ignored)
       {"name",       no_argument,       0, 'n'},
       {"capability", no_argument,       0, 'C'},
@@ -1130,6 +1330,9 @@ void Zypper::processCommandOptions()
       "                            Default: %s.\n"
       "-n, --name                  Select packages by plain name, not by capability.\n"
       "-C, --capability            Select packages by capability.\n"
+      "    --from-file <file>      Read the packages from the file, one per line\n"
+      "                            ('-' for standard input, with\n"
+      "                            --non-interactive).\n"
       "    --debug-solver          Create solver test case for debugging.\n"
       "-R, --no-force-resolution   Do not force the solver to find solution,\n"
       "                            let it ask.\n"
@@ -1206,7 +1409,7 @@ void Zypper::processCommandOptions()
       "    --download              Set the download-install mode. Available modes:\n"
       "                            %s\n"
       "-d, --download-only         Only download the packages, do not install.\n"
-    ), "only, in-advance, in-heaps, as-needed");
+    ), "only, in-advance, in-heaps, as-needed, pipelined");
     break;
   }
 
@@ -1241,7 +1444,7 @@ void Zypper::processCommandOptions()
       "                            %s\n"
       "-d, --download-only         Only download the packages, do not install.\n"
       "    --debug-solver          Create solver test case for debugging.\n"
-    ), "only, in-advance, in-heaps, as-needed");
+    ), "only, in-advance, in-heaps, as-needed, pipelined");
     break;
   }
 
@@ -1634,6 +1837,7 @@ void Zypper::processCommandOptions()
       {"metadata", no_argument, 0, 'm'},
       {"raw-metadata", no_argument, 0, 'M'},
       {"all", no_argument, 0, 'a'},
+      {"budget", no_argument, 0, 'b'},
       {0, 0, 0, 0}
     };
     specific_options = service_list_options;
@@ -1647,6 +1851,9 @@ void Zypper::processCommandOptions()
       "-m, --metadata           Clean metadata cache.\n"
       "-M, --raw-metadata       Clean raw metadata cache.\n"
       "-a, --all                Clean both metadata and package caches.\n"
+      "-b, --budget             Only remove the least recently used packages\n"
+      "                         exceeding the package cache limits set in\n"
+      "                         zypper.conf, and show the cache's hit rate.\n"
     );
     break;
   }
@@ -1757,7 +1964,7 @@ void Zypper::processCommandOptions()
       "-d, --download-only         Only download the packages, do not install.\n"
     ), "package, patch, pattern, product, srcpackage",
        "package",
-       "only, in-advance, in-heaps, as-needed");
+       "only, in-advance, in-heaps, as-needed, pipelined");
     break;
   }
 
@@ -1814,7 +2021,7 @@ void Zypper::processCommandOptions()
       "    --download              Set the download-install mode. Available modes:\n"
       "                            %s\n"
       "-d, --download-only         Only download the packages, do not install.\n"
-    ), "only, in-advance, in-heaps, as-needed");
+    ), "only, in-advance, in-heaps, as-needed, pipelined");
     break;
   }
 
@@ -1894,7 +2101,7 @@ void Zypper::processCommandOptions()
       "    --download              Set the download-install mode. Available modes:\n"
       "                            %s\n"
       "-d, --download-only         Only download the packages, do not install.\n"
-    ), "only, in-advance, in-heaps, as-needed");
+    ), "only, in-advance, in-heaps, as-needed, pipelined");
     break;
   }
 
@@ -2411,15 +2618,17 @@ void Zypper::processCommandOptions()
     static struct option options[] =
     {
       {"help", no_argument, 0, 'h'},
+      {"parallel", no_argument, 0, 0},
       {0, 0, 0, 0}
     };
     specific_options = options;
     _command_help = _(
-      "ps\n"
+      "ps [options]\n"
       "\n"
       "List running processes which use files deleted by recent upgrades.\n"
       "\n"
-      "This command has no additional options.\n"
+      "  Command options:\n"
+      "    --parallel    Scan the processes using several threads.\n"
     );
     break;
   }
@@ -2495,6 +2704,30 @@ void Zypper::processCommandOptions()
     break;
   }
 
+  case ZypperCommand::SERVE_e:
+  {
+    static struct option serve_options[] = {
+      {"socket", required_argument, 0, 's'},
+      {"help", no_argument, 0, 'h'},
+      {0, 0, 0, 0}
+    };
+    specific_options = serve_options;
+    _command_help = _(
+      "serve --socket <path>\n"
+      "\n"
+      "Keep the pool loaded and answer queries sent to a Unix socket.\n"
+      "Each request is a line with a JSON array of the command and its\n"
+      "arguments, e.g. [\"search\", \"vim\"]. Only commands which do not\n"
+      "change the system are served: search, info, what-provides, packages,\n"
+      "patches, patterns, products, list-updates, list-patches, patch-check,\n"
+      "repos, services and locks.\n"
+      "\n"
+      "  Command options:\n"
+      "-s, --socket <path>     The socket to listen on.\n"
+    );
+    break;
+  }
+
   case ZypperCommand::RUG_SERVICE_TYPES_e:
   {
     static struct option options[] = {
@@ -3420,7 +3653,10 @@ void Zypper::doCommand()
     }
 
     initRepoManager();
-    clean_repos(*this);
+    if (copts.count("budget"))
+      limit_package_cache(*this, Out::NORMAL);
+    else
+      clean_repos(*this);
     break;
   }
 
@@ -3431,7 +3667,8 @@ void Zypper::doCommand()
   {
     if (runningHelp()) { out().info(_command_help, Out::QUIET); return; }
 
-    if (_arguments.size() < 1 && !_copts.count("entire-catalog"))
+    if (_arguments.size() < 1 && !_copts.count("entire-catalog")
+        && !_copts.count("from-file"))
     {
       out().error(
           _("Too few arguments."),
@@ -3441,6 +3678,17 @@ void Zypper::doCommand()
       return;
     }
 
+    // the prompts read the standard input too
+    if (_copts.count("from-file") && _copts["from-file"].back() == "-"
+        && !globalOpts().non_interactive)
+    {
+      out().error(
+          _("Reading the packages from the standard input requires non-interactive mode."),
+          _("Use the global --non-interactive option."));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+
     // check root user
     if (geteuid() != 0 && !globalOpts().changedRoot)
     {
@@ -3519,6 +3767,7 @@ void Zypper::doCommand()
     ArgList rpms_files_caps;
     if (install_not_remove)
     {
+      vector<string> rpm_files;
       for (vector<string>::iterator it = _arguments.begin();
             it != _arguments.end(); )
       {
@@ -3528,46 +3777,7 @@ void Zypper::doCommand()
           out().info(boost::str(format(
             _("'%s' looks like an RPM file. Will try to download it.")) % *it),
             Out::HIGH);
-
-          // download the rpm into the cache
-          //! \todo do we want this or a tmp dir? What about the files cached before?
-          //! \todo optimize: don't mount the same media multiple times for each rpm
-          Pathname rpmpath = cache_rpm(*it,
-              (_gopts.root_dir != "/" ? _gopts.root_dir : "")
-              + ZYPPER_RPM_CACHE_DIR);
-
-          if (rpmpath.empty())
-          {
-            out().error(boost::str(format(
-              _("Problem with the RPM file specified as '%s', skipping."))
-              % *it));
-          }
-          else
-          {
-            using target::rpm::RpmHeader;
-            // rpm header (need name-version-release)
-            RpmHeader::constPtr header =
-              RpmHeader::readPackage(rpmpath, RpmHeader::NOSIGNATURE);
-            if (header)
-            {
-              string nvrcap =
-                TMP_RPM_REPO_ALIAS ":" +
-                header->tag_name() + "=" +
-                str::numstring(header->tag_epoch()) + ":" +
-                header->tag_version() + "-" +
-                header->tag_release();
-              DBG << "rpm package capability: " << nvrcap << endl;
-
-              // store the rpm file capability string (name=version-release)
-              rpms_files_caps.push_back(nvrcap);
-            }
-            else
-            {
-              out().error(boost::str(format(
-                _("Problem reading the RPM header of %s. Is it an RPM file?"))
-                  % *it));
-            }
-          }
+          rpm_files.push_back(*it);
 
           // remove this rpm argument
           it = _arguments.erase(it);
@@ -3575,6 +3785,49 @@ void Zypper::doCommand()
         else
           ++it;
       }
+
+      // download the rpms into the cache, all at once
+      //! \todo do we want this or a tmp dir? What about the files cached before?
+      vector<Pathname> rpmpaths;
+      if (!rpm_files.empty())
+        rpmpaths = cache_rpms(rpm_files,
+            (_gopts.root_dir != "/" ? _gopts.root_dir : "")
+            + ZYPPER_RPM_CACHE_DIR);
+
+      for (unsigned i = 0; i < rpmpaths.size(); ++i)
+      {
+        if (rpmpaths[i].empty())
+        {
+          out().error(boost::str(format(
+            _("Problem with the RPM file specified as '%s', skipping."))
+            % rpm_files[i]));
+          continue;
+        }
+
+        using target::rpm::RpmHeader;
+        // rpm header (need name-version-release)
+        RpmHeader::constPtr header =
+          RpmHeader::readPackage(rpmpaths[i], RpmHeader::NOSIGNATURE);
+        if (header)
+        {
+          string nvrcap =
+            TMP_RPM_REPO_ALIAS ":" +
+            header->tag_name() + "=" +
+            str::numstring(header->tag_epoch()) + ":" +
+            header->tag_version() + "-" +
+            header->tag_release();
+          DBG << "rpm package capability: " << nvrcap << endl;
+
+          // store the rpm file capability string (name=version-release)
+          rpms_files_caps.push_back(nvrcap);
+        }
+        else
+        {
+          out().error(boost::str(format(
+            _("Problem reading the RPM header of %s. Is it an RPM file?"))
+              % rpm_files[i]));
+        }
+      }
     }
 
     // if there were some rpm files, add the rpm cache as a temporary plaindir repo
@@ -3608,7 +3861,7 @@ void Zypper::doCommand()
       out().setVerbosity(tmp);
     }
     // no rpms and no other arguments either
-    else if (_arguments.empty())
+    else if (_arguments.empty() && !_copts.count("from-file"))
     {
       out().error(_("No valid arguments specified."));
       setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
@@ -3640,7 +3893,25 @@ void Zypper::doCommand()
     PackageArgs::Options argopts;
     if (!install_not_remove)
       argopts.do_by_default = false;
-    PackageArgs args(kind, argopts);
+    shared_ptr<PackageArgs> argsptr;
+    if ((optit = copts.find("from-file")) != copts.end())
+    {
+      // the manifest is streamed in, so that it can be big
+      const string & file(optit->second.back());
+      std::ifstream manifest;
+      if (file != "-")
+        manifest.open(file.c_str());
+      if (file != "-" && !manifest)
+      {
+        out().error(boost::str(format(_("Cannot read file '%s'.")) % file));
+        setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+        return;
+      }
+      argsptr.reset(new PackageArgs(file == "-" ? std::cin : manifest, kind, argopts));
+    }
+    else
+      argsptr.reset(new PackageArgs(kind, argopts));
+    const PackageArgs & args(*argsptr);
 
     // tell the solver what we want
 
@@ -4415,6 +4686,7 @@ void Zypper::doCommand()
             // this will do a complete pacakge update as far as possible
             // while respecting solver policies
             zypp::getZYpp()->resolver()->doUpdate();
+            UpdateCandidates::instance().patchStatusChanged();
             // no need to call Resolver::resolvePool() afterwards
             runtimeData().solve_before_commit = false;
           }
@@ -4835,7 +5107,7 @@ void Zypper::doCommand()
       return;
     }
 
-    list_processes_using_deleted_files(*this);
+    list_processes_using_deleted_files(*this, copts.count("parallel"));
 
     break;
   }
@@ -4894,6 +5166,19 @@ void Zypper::doCommand()
     break;
   }
 
+  case ZypperCommand::SERVE_e:
+  {
+    if (runningHelp())
+      out().info(_command_help, Out::QUIET);
+    else
+    {
+      out().error(_("Unexpected program flow."));
+      report_a_bug(out());
+    }
+
+    break;
+  }
+
   case ZypperCommand::RUG_SERVICE_TYPES_e:
   {
     if (runningHelp()) { out().info(_command_help, Out::QUIET); return; }
@@ -4957,6 +5242,9 @@ void Zypper::cleanup()
       out().setVerbosity(tmp);
       break;
     }
+
+  if (!_gopts.profile.empty() && !Profiler::instance().write(_gopts.profile))
+    out().error(boost::str(format(_("Cannot write file '%s'.")) % _gopts.profile));
 }
 
 void rug_list_resolvables(Zypper & zypper)
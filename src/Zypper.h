@@ -70,7 +70,9 @@ struct GlobalOptions
   no_abbrev(false),
   terse(false),
   changedRoot(false),
-  ignore_unknown(false)
+  ignore_unknown(false),
+  timings(false),
+  solver_stats(false)
   {}
 
 //  std::list<zypp::Url> additional_sources;
@@ -106,6 +108,12 @@ struct GlobalOptions
   bool terse;
   bool changedRoot;
   bool ignore_unknown;
+  /** Whether to report where the time was spent (--timings) */
+  bool timings;
+  /** Whether to report what the solver did (--solver-stats) */
+  bool solver_stats;
+  /** Where to write the trace of the phases of the run (--profile) */
+  std::string profile;
 };
 
 /**
@@ -113,6 +121,10 @@ struct GlobalOptions
  * zypp::RepoManager. Consider using your own RepoInfos only for those not
  * maintained by zypp::RepoManager. (bnc #544432)
 */
+class PackagePrefetcher;
+class PackageStore;
+class PoolWatcher;
+
 struct RuntimeData
 {
   RuntimeData()
@@ -127,6 +139,10 @@ struct RuntimeData
     , seen_verify_hint(false)
     , action_rpm_download(false)
     , waiting_for_input(false)
+    , target_initialized(false)
+    , repos_initialized(false)
+    , repos_loaded(false)
+    , target_loaded(false)
   {}
 
   std::list<zypp::RepoInfo> repos;
@@ -168,6 +184,11 @@ struct RuntimeData
   unsigned int rpm_pkgs_total;
   unsigned int rpm_pkg_current;
 
+  /** Fetches the packages of a pipelined commit (--download pipelined), if any. */
+  zypp::shared_ptr<PackagePrefetcher> prefetcher;
+  /** Shares the packages of a commit with other repos and roots (cache.packagesStore), if any. */
+  zypp::shared_ptr<PackageStore> packageStore;
+
   bool seen_verify_hint;
   bool action_rpm_download;
 
@@ -176,10 +197,23 @@ struct RuntimeData
 
   //! Temporary directory for any use. Used e.g. as packagesPath of TMP_RPM_REPO_ALIAS repository.
   zypp::filesystem::TmpDir tmpdir;
+
+  /** What init_target(), init_repos() and load_resolvables() did already
+   * (the zypper shell keeps the pool across commands). */
+  bool target_initialized;
+  bool repos_initialized;
+  bool repos_loaded;
+  bool target_loaded;
+  /** The repos given for the command which initialized \ref repos. */
+  std::string repos_selection;
+  /** Notices changes of what the pool was loaded from (zypper shell only). */
+  zypp::shared_ptr<PoolWatcher> pool_watcher;
 };
 
 typedef zypp::shared_ptr<zypp::RepoManager> RepoManager_Ptr;
 
+class RepoIndex;
+
 class Zypper : private zypp::base::NonCopyable
 {
 public:
@@ -203,10 +237,16 @@ public:
   RuntimeData & runtimeData() { return _rdata; }
 
   zypp::RepoManager & repoManager()
-  { if (!_rm) _rm.reset(new zypp::RepoManager(_gopts.rm_options)); return *_rm; }
+  { if (!_rm) initRepoManager(); return *_rm; }
 
   void initRepoManager()
-  { _rm.reset(new zypp::RepoManager(_gopts.rm_options)); }
+  { _rm.reset(new zypp::RepoManager(_gopts.rm_options)); _repo_index.reset(); }
+
+  /** Lookup index of the repoManager()'s repos, built on first use. */
+  const RepoIndex & repoIndex();
+
+  /** Drop the repoIndex() after adding, removing or modifying repos. */
+  void reposChanged() { _repo_index.reset(); }
 
   int exitCode() const { return _exit_code; }
   void setExitCode(int exit) { _exit_code = exit; }
@@ -236,6 +276,13 @@ public:
    */
   int defaultLoadSystem( LoadSystemFlags flags_r = LoadSystemFlags() );
 
+  /** What the current command can do without, given its options.
+   * \ref NO_TARGET if its result does not depend on the installed
+   * packages, in which case \ref load_resolvables does not read the
+   * rpm database.
+   */
+  LoadSystemFlags commandLoadFlags() const;
+
 public:
   /** Convenience to return properly casted _commandOptions. */
   template<class _Opt>
@@ -263,6 +310,7 @@ private:
   void processGlobalOptions();
   void processCommandOptions();
   void commandShell();
+  void commandServe();
   void shellCleanup();
   void safeDoCommand();
   void doCommand();
@@ -292,6 +340,7 @@ private:
   RuntimeData _rdata;
 
   RepoManager_Ptr   _rm;
+  zypp::shared_ptr<RepoIndex> _repo_index;
 
   int _sh_argc;
   char **_sh_argv;
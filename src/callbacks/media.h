@@ -9,7 +9,6 @@
 #define ZMART_MEDIA_CALLBACKS_H
 
 #include <stdlib.h>
-#include <ctime>
 
 #include <zypp/ZYppCallbacks.h>
 #include <zypp/base/Logger.h>
@@ -67,30 +66,16 @@ namespace ZmartRecipients
     : public zypp::callback::ReceiveReport<zypp::media::DownloadProgressReport>
   {
     DownloadProgressReportReceiver()
-      : _gopts(Zypper::instance()->globalOpts()), _be_quiet(false)
+      : _gopts(Zypper::instance()->globalOpts())
     {}
 
     virtual void start( const zypp::Url & uri, zypp::Pathname localfile )
     {
-      _last_reported = time(NULL);
-      _last_drate_avg = -1;
-
       Out & out = Zypper::instance()->out();
+      out.downloads().start(uri);
 
-      if (out.verbosity() < Out::HIGH &&
-           (
-             // don't show download info unless show_media_progress_hack is used
-             !Zypper::instance()->runtimeData().show_media_progress_hack ||
-             // don't report download of the media file (bnc #330614)
-             zypp::Pathname(uri.getPathName()).basename() == "media"
-           )
-         )
-      {
-        _be_quiet = true;
+      if (beQuiet(uri))
         return;
-      }
-      else
-        _be_quiet = false;
 
       out.dwnldProgressStart(uri);
     }
@@ -98,15 +83,12 @@ namespace ZmartRecipients
     //! \todo return false on SIGINT
     virtual bool progress(int value, const zypp::Url & uri, double drate_avg, double drate_now)
     {
-      // don't report more often than 1 second
-      time_t now = time(NULL);
-      if (now > _last_reported)
-        _last_reported = now;
-      else
-        return true;
-
       Zypper & zypper = *(Zypper::instance());
 
+      // don't report more often than 1 second per transfer
+      if (!zypper.out().downloads().progress(uri, value, (long) drate_now, (long) drate_avg))
+        return true;
+
       if (zypper.exitRequested())
       {
         DBG << "received exit request" << std::endl;
@@ -117,11 +99,10 @@ namespace ZmartRecipients
         zypper.out().progress(
           "raw-refresh", zypper.runtimeData().raw_refresh_progress_label);
 
-      if (_be_quiet)
+      if (beQuiet(uri))
         return true;
 
       zypper.out().dwnldProgress(uri, value, (long) drate_now);
-      _last_drate_avg = drate_avg;
       return true;
     }
 
@@ -129,8 +110,8 @@ namespace ZmartRecipients
     problem( const zypp::Url & uri, DownloadProgressReport::Error error, const std::string & description )
     {
       DBG << "media problem" << std::endl;
-      if (_be_quiet)
-        Zypper::instance()->out().dwnldProgressEnd(uri, _last_drate_avg, true);
+      if (beQuiet(uri))
+        Zypper::instance()->out().dwnldProgressEnd(uri, lastRateAvg(uri), true);
       Zypper::instance()->out().error(zcb_error2str(error, description));
 
       Action action = (Action) read_action_ari(
@@ -143,18 +124,37 @@ namespace ZmartRecipients
     // used only to finish, errors will be reported in media change callback (libzypp 3.20.0)
     virtual void finish( const zypp::Url & uri, Error error, const std::string & konreason )
     {
-      if (_be_quiet)
+      Out & out = Zypper::instance()->out();
+      long rate = lastRateAvg(uri);
+      out.downloads().finish(uri, error != NO_ERROR);
+
+      if (beQuiet(uri))
         return;
 
-      Zypper::instance()->out().dwnldProgressEnd(
-          uri, _last_drate_avg, error != NO_ERROR);
+      out.dwnldProgressEnd(uri, rate, error != NO_ERROR);
+    }
+
+  private:
+    bool beQuiet(const zypp::Url & uri) const
+    {
+      Zypper & zypper = *Zypper::instance();
+      return zypper.out().verbosity() < Out::HIGH &&
+           (
+             // don't show download info unless show_media_progress_hack is used
+             !zypper.runtimeData().show_media_progress_hack ||
+             // don't report download of the media file (bnc #330614)
+             zypp::Pathname(uri.getPathName()).basename() == "media"
+           );
+    }
+
+    long lastRateAvg(const zypp::Url & uri) const
+    {
+      const DownloadSet::Transfer * transfer = Zypper::instance()->out().downloads().transfer(uri);
+      return transfer ? transfer->rateAvg : -1;
     }
 
   private:
     const GlobalOptions & _gopts;
-    bool _be_quiet;
-    time_t _last_reported;
-    double _last_drate_avg;
   };
 
 
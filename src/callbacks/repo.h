@@ -45,6 +45,7 @@ struct DownloadResolvableReportReceiver : public zypp::callback::ReceiveReport<z
   {
     _delta = filename;
     _delta_size = downloadsize;
+    Zypper::instance()->out().downloads().sizeHint(_delta_size);
     std::ostringstream s;
     s << _("Retrieving delta") << ": "
         << _delta << ", " << _delta_size;
@@ -111,6 +112,7 @@ struct DownloadResolvableReportReceiver : public zypp::callback::ReceiveReport<z
   {
     _patch = filename.basename();
     _patch_size = downloadsize;
+    Zypper::instance()->out().downloads().sizeHint(_patch_size);
     std::ostringstream s;
     s << _("Retrieving patch rpm") << ": " << _patch << ", " << _patch_size;
     Zypper::instance()->out().info(s.str());
@@ -164,6 +166,7 @@ struct DownloadResolvableReportReceiver : public zypp::callback::ReceiveReport<z
     zypp::Package::constPtr ro = zypp::asKind<zypp::Package> (resolvable_ptr);
     if ( ro )
     {
+      zypper.out().downloads().sizeHint( ro->downloadSize() );
       outstr.rhs << ", " << ro->downloadSize().asString( 5 ) << " "
           // TranslatorExplanation %s is package size like "5.6 M"
           << boost::format(_("(%s unpacked)")) % ro->installSize().asString( 5 );
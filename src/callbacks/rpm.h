@@ -21,6 +21,8 @@
 #include <zypp/Patch.h>
 
 #include "Zypper.h"
+#include "PackagePrefetcher.h"
+#include "PackageStore.h"
 #include "output/prompt.h"
 
 
@@ -180,6 +182,10 @@ struct RemoveResolvableReportReceiver : public zypp::callback::ReceiveReport<zyp
       if (!reason.empty())
         Zypper::instance()->out().info(reason);
     }
+
+    // have the next package on disk for the pipelined commit
+    if (Zypper::instance()->runtimeData().prefetcher)
+      Zypper::instance()->runtimeData().prefetcher->stepDone();
   }
 };
 
@@ -216,6 +222,11 @@ struct InstallResolvableReportReceiver : public zypp::callback::ReceiveReport<zy
     _label += boost::str(boost::format(_("Installing: %s-%s"))
         % resolvable->name() % resolvable->edition());
     Zypper::instance()->out().progressStart("install-resolvable", _label);
+
+    if (zypper.runtimeData().prefetcher)
+      zypper.runtimeData().prefetcher->installing(resolvable);
+    if (zypper.runtimeData().packageStore)
+      zypper.runtimeData().packageStore->installing(resolvable);
   }
 
   virtual bool progress( int value, zypp::Resolvable::constPtr resolvable )
@@ -267,6 +278,10 @@ struct InstallResolvableReportReceiver : public zypp::callback::ReceiveReport<zy
       if (!reason.empty())
         Zypper::instance()->out().info(reason);
     }
+
+    // have the next package on disk for the pipelined commit
+    if (Zypper::instance()->runtimeData().prefetcher)
+      Zypper::instance()->runtimeData().prefetcher->stepDone();
   }
 };
 
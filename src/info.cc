@@ -51,8 +51,8 @@ void printSummaryDesc(const ResObject::constPtr & res)
   cout << _("Description: ") << endl;
   const string& s = res->description();
   if (s.find("DT:Rich")!=s.npos){
-    string ns = processRichText(s);
-    cout << ns << endl;
+    processRichText(s, cout);
+    cout << endl;
   }
   else
   {
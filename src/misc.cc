@@ -187,7 +187,7 @@ bool confirm_licenses(Zypper & zypper)
       if (licenseText.find("DT:Rich")==licenseText.npos)
         s << licenseText;
       else
-        s << processRichText(licenseText);
+        processRichText(licenseText, s);
 
       // show in pager unless we are read by a machine or the pager fails
       if (zypper.globalOpts().machine_readable || !show_text_in_pager(s.str()))
@@ -295,7 +295,7 @@ void report_licenses(Zypper & zypper)
         if (licenseText.find("DT:Rich")==licenseText.npos)
           cout << licenseText;
         else
-          cout << processRichText(licenseText);
+          processRichText(licenseText, cout);
         cout << endl;
 
         ++count_installed_eula;
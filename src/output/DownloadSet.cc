@@ -0,0 +1,147 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include "utils/misc.h"
+
+#include "DownloadSet.h"
+
+using zypp::ByteCount;
+using zypp::Url;
+
+// don't report a transfer more often than this (ms)
+static const unsigned long long reportInterval = 1000;
+
+DownloadSet::DownloadSet()
+  : _filesExpected( 0 ), _filesDone( 0 ), _filesFailed( 0 ), _started( 0 )
+{}
+
+void DownloadSet::expect( unsigned files_r, const ByteCount & bytes_r )
+{
+  reset();
+  _filesExpected = files_r;
+  _bytesExpected = bytes_r;
+}
+
+void DownloadSet::reset()
+{
+  _transfers.clear();
+  _sizeHint = ByteCount();
+  _filesExpected = 0;
+  _bytesExpected = ByteCount();
+  _filesDone = 0;
+  _filesFailed = 0;
+  _bytesFinished = ByteCount();
+  _started = 0;
+}
+
+void DownloadSet::start( const Url & url_r )
+{
+  unsigned long long now = monotonic_ms();
+  if ( ! _started )
+    _started = now;
+
+  Transfer & t( _transfers[url_r.asString()] );
+  t = Transfer();
+  t.url = url_r;
+  t.expected = _sizeHint;
+  t.lastUpdate = now;
+  t.lastReported = now;
+  _sizeHint = ByteCount();
+}
+
+bool DownloadSet::progress( const Url & url_r, int percent_r, long rate_r, long rateAvg_r )
+{
+  Transfers::iterator it( _transfers.find( url_r.asString() ) );
+  if ( it == _transfers.end() )
+    return true;	// not started via this set; just let it through
+
+  Transfer & t( it->second );
+  unsigned long long now = monotonic_ms();
+
+  if ( t.expected && percent_r >= 0 )
+    t.bytes = t.expected * percent_r / 100;
+  else if ( rate_r > 0 )
+    t.bytes += ByteCount::SizeType( rate_r ) * ( now - t.lastUpdate ) / 1000;
+
+  t.percent = percent_r;
+  t.rate = rate_r;
+  t.rateAvg = rateAvg_r;
+  t.lastUpdate = now;
+
+  if ( now - t.lastReported < reportInterval )
+    return false;
+  t.lastReported = now;
+  return true;
+}
+
+void DownloadSet::finish( const Url & url_r, bool error_r )
+{
+  Transfers::iterator it( _transfers.find( url_r.asString() ) );
+  if ( it == _transfers.end() )
+    return;
+
+  if ( error_r )
+    ++_filesFailed;
+  else
+  {
+    ++_filesDone;
+    _bytesFinished += ( it->second.expected ? it->second.expected : it->second.bytes );
+  }
+  _transfers.erase( it );
+
+  if ( _transfers.empty() && ! _filesExpected )
+    reset();	// nothing announced: each batch stands on its own
+}
+
+const DownloadSet::Transfer * DownloadSet::transfer( const Url & url_r ) const
+{
+  Transfers::const_iterator it( _transfers.find( url_r.asString() ) );
+  return it == _transfers.end() ? 0 : &it->second;
+}
+
+unsigned DownloadSet::filesExpected() const
+{
+  unsigned seen = _filesDone + _filesFailed + _transfers.size();
+  return _filesExpected > seen ? _filesExpected : seen;
+}
+
+ByteCount DownloadSet::bytesDone() const
+{
+  ByteCount ret( _bytesFinished );
+  for ( Transfers::const_iterator it = _transfers.begin(); it != _transfers.end(); ++it )
+    ret += it->second.bytes;
+  return ret;
+}
+
+long DownloadSet::rate() const
+{
+  long ret = -1;
+  for ( Transfers::const_iterator it = _transfers.begin(); it != _transfers.end(); ++it )
+  {
+    if ( it->second.rate > 0 )
+      ret = ( ret < 0 ? 0 : ret ) + it->second.rate;
+  }
+  return ret;
+}
+
+long DownloadSet::eta() const
+{
+  if ( ! _started || ! _bytesExpected )
+    return -1;
+
+  ByteCount done( bytesDone() );
+  if ( done >= _bytesExpected )
+    return 0;
+
+  // average over the whole set is more stable than the current rate
+  unsigned long long elapsed = monotonic_ms() - _started;
+  if ( elapsed < 1000 || ! done )
+    return -1;
+
+  ByteCount::SizeType left = _bytesExpected - done;
+  return left * elapsed / done / 1000;
+}
@@ -0,0 +1,120 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef DOWNLOADSET_H_
+#define DOWNLOADSET_H_
+
+#include <map>
+#include <string>
+
+#include <zypp/Url.h>
+#include <zypp/ByteCount.h>
+
+///////////////////////////////////////////////////////////////////
+/// \class DownloadSet
+/// \brief Bookkeeping for a set of (possibly concurrent) downloads.
+///
+/// Tracks all in-flight transfers by URL and aggregates bytes, rate
+/// and ETA across them. The media download callbacks feed it, the
+/// \ref Out implementations render it.
+///
+/// If the expected number of files and bytes is announced via
+/// \ref expect (e.g. from the commit summary), counters are kept until
+/// \ref reset. Otherwise they are cleared whenever the last in-flight
+/// transfer finishes.
+///////////////////////////////////////////////////////////////////
+class DownloadSet
+{
+public:
+  struct Transfer
+  {
+    Transfer()
+    : percent( -1 ), rate( -1 ), rateAvg( -1 ), lastUpdate( 0 ), lastReported( 0 )
+    {}
+
+    zypp::Url url;
+    zypp::ByteCount expected;		//< expected size, 0 if unknown
+    zypp::ByteCount bytes;		//< bytes received (estimated from rate if size is unknown)
+    int percent;			//< -1 if unknown
+    long rate;				//< current rate in B/s, -1 if unknown
+    long rateAvg;			//< average rate in B/s, -1 if unknown
+    unsigned long long lastUpdate;	//< ms
+    unsigned long long lastReported;	//< ms
+  };
+  typedef std::map<std::string, Transfer> Transfers;
+
+public:
+  DownloadSet();
+
+  /** Announce the number of files and bytes about to be downloaded. */
+  void expect( unsigned files_r, const zypp::ByteCount & bytes_r );
+
+  /** Expected size of the file started next (e.g. a package's download size). */
+  void sizeHint( const zypp::ByteCount & size_r )
+  { _sizeHint = size_r; }
+
+  /** Forget everything. */
+  void reset();
+
+  void start( const zypp::Url & url_r );
+
+  /** Update a transfer.
+   * \returns whether the update should be reported (at most once per second
+   * for each transfer).
+   */
+  bool progress( const zypp::Url & url_r, int percent_r, long rate_r, long rateAvg_r );
+
+  void finish( const zypp::Url & url_r, bool error_r );
+
+public:
+  /** Whether there is more than a single file to report about. */
+  bool aggregate() const
+  { return _filesExpected > 1 || _transfers.size() > 1; }
+
+  const Transfers & transfers() const
+  { return _transfers; }
+
+  /** The transfer for \a url_r or \c NULL. */
+  const Transfer * transfer( const zypp::Url & url_r ) const;
+
+  unsigned inFlight() const
+  { return _transfers.size(); }
+
+  unsigned filesDone() const
+  { return _filesDone; }
+
+  unsigned filesFailed() const
+  { return _filesFailed; }
+
+  /** Expected number of files, at least the ones seen so far. */
+  unsigned filesExpected() const;
+
+  /** Bytes of finished and in-flight transfers. */
+  zypp::ByteCount bytesDone() const;
+
+  /** Expected bytes, 0 if unknown. */
+  zypp::ByteCount bytesExpected() const
+  { return _bytesExpected; }
+
+  /** Sum of the current rates of all in-flight transfers in B/s, -1 if unknown. */
+  long rate() const;
+
+  /** Estimated seconds to go, -1 if unknown. */
+  long eta() const;
+
+private:
+  Transfers _transfers;
+  zypp::ByteCount _sizeHint;
+  unsigned _filesExpected;
+  zypp::ByteCount _bytesExpected;
+  unsigned _filesDone;
+  unsigned _filesFailed;
+  zypp::ByteCount _bytesFinished;
+  unsigned long long _started;	//< ms, 0 if nothing started yet
+};
+
+#endif /*DOWNLOADSET_H_*/
@@ -1,4 +1,5 @@
 #include <unistd.h>
+#include <cstdio>
 
 #include <iostream>
 #include <sstream>
@@ -77,6 +78,121 @@ std::string TermLine::get( unsigned width_r, SplitFlags flags_r, char exp_r ) co
   return zypp::str::Str() << l << r;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//	class TermLineLayout
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+  /** utf8 size of \a len_r bytes at \a str_r (continuation bytes not counted) */
+  inline unsigned utf8Size( const char * str_r, unsigned len_r )
+  {
+    unsigned ret = len_r;
+    for ( const char * end = str_r + len_r; str_r != end; ++str_r )
+    {
+      if ( ( *str_r & 0xC0 ) == 0x80 )
+        --ret;
+    }
+    return ret;
+  }
+
+  /** Byte length of the first \a n_r utf8 characters of \a len_r bytes at \a str_r */
+  inline std::string::size_type utf8Prefix( const char * str_r, std::string::size_type len_r, unsigned n_r )
+  {
+    std::string::size_type pos = 0;
+    for ( unsigned chars = 0; pos < len_r; ++pos )
+    {
+      if ( ( str_r[pos] & 0xC0 ) != 0x80 )
+      {
+        if ( chars == n_r )
+          break;
+        ++chars;
+      }
+    }
+    return pos;
+  }
+} // namespace
+
+TermLineLayout::TermLineLayout( char exp_r )
+  : _exp( exp_r )
+  , _expand( ::isatty( STDOUT_FILENO ) )
+  , _llen( 0 )
+  , _prefixChars( 0 )
+  , _prefixBytes( 0 )
+{}
+
+bool TermLineLayout::setLhs( const std::string & text_r, const char * suffix_r )
+{
+  if ( text_r == _text && ! _lhs.empty() )
+    return false;
+
+  // assign() reuses the capacity
+  _text.assign( text_r );
+  _lhs.assign( text_r ).append( suffix_r );
+  _llen = utf8::string( _lhs ).size();
+  _prefixChars = 0;
+  _prefixBytes = 0;
+  return true;
+}
+
+std::string::size_type TermLineLayout::lhsPrefix( unsigned n_r )
+{
+  if ( n_r != _prefixChars || ! _prefixBytes )
+  {
+    _prefixChars = n_r;
+    _prefixBytes = utf8Prefix( _lhs.c_str(), _lhs.size(), n_r );
+  }
+  return _prefixBytes;
+}
+
+const std::string & TermLineLayout::render( unsigned width_r, int percent_r, const char * rhs_r, unsigned rhslen_r )
+{
+  _buf.clear();	// keeps the capacity
+  if ( _buf.capacity() < _lhs.size() + width_r + rhslen_r )
+    _buf.reserve( _lhs.size() + width_r + rhslen_r );
+
+  unsigned rlen = utf8Size( rhs_r, rhslen_r );
+  int diff = width_r - _llen - rlen;
+
+  if ( width_r == 0 || diff == 0 || ( diff > 0 && ! _expand ) )
+  {
+    // plain line if zero width, fits exactly or no expansion
+    _buf.append( _lhs ).append( rhs_r, rhslen_r );
+  }
+  else if ( diff > 0 )
+  {
+    // expand... (see TermLine::get)
+    _buf.append( _lhs );
+    if ( percent_r < 0 || percent_r > 100 )
+      _buf.append( diff, _exp );
+    else if ( percent_r == 0 )
+      _buf.append( diff, '-' );
+    else
+    {
+      int pc = diff * percent_r / 100;
+      if ( diff < 6 )	// not enough space for fancy stuff
+        _buf.append( pc, '.' ).append( diff-pc, '=' );
+      else
+      {
+        char tag[8];
+        int taglen = ::snprintf( tag, sizeof(tag), "<%d%%>", percent_r );
+        pc = ( pc > taglen ? pc - taglen : 0 );
+        _buf.append( pc, '.' ).append( tag, taglen ).append( diff-pc-taglen, '=' );
+      }
+    }
+    _buf.append( rhs_r, rhslen_r );
+  }
+  else
+  {
+    // crush...
+    if ( rlen > width_r )
+      _buf.append( rhs_r, utf8Prefix( rhs_r, rhslen_r, width_r ) );
+    else
+      _buf.append( _lhs, 0, lhsPrefix( width_r - rlen ) ).append( rhs_r, rhslen_r );
+  }
+  return _buf;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //	class Out
 ////////////////////////////////////////////////////////////////////////////////
@@ -15,6 +15,7 @@
 
 #include "utils/prompt.h"
 #include "output/prompt.h"
+#include "output/DownloadSet.h"
 
 using zypp::tribool;
 using zypp::indeterminate;
@@ -70,6 +71,59 @@ struct TermLine
 };
 ZYPP_DECLARE_OPERATORS_FOR_FLAGS( TermLine::SplitFlags );
 
+///////////////////////////////////////////////////////////////////
+/// \class TermLineLayout
+/// \brief Precomputed \ref TermLine layout for progress lines.
+///
+/// Renders like <tt>TermLine::get( width, SF_CRUSH|SF_EXPAND, exp )</tt>,
+/// but for lines redrawn on every tick where only the percentage
+/// indicator and a short rhs (like the alive cursor) change:
+/// The lhs is stored and measured once and the line is rendered into
+/// a reusable buffer. After the first \ref render for a given width and
+/// lhs, no memory is allocated. Embedded esc sequences are not supported.
+///
+/// \code
+///   TermLineLayout line( '-' );
+///   line.setLhs( label, " " );		// no-op if label is unchanged
+///   const char rhs[] = { '[', cursor.current(), ']' };
+///   cout << line.render( width, percent, rhs, sizeof(rhs) );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class TermLineLayout
+{
+public:
+  TermLineLayout( char exp_r = ' ' );
+
+  /** Set the lhs to \a text_r followed by \a suffix_r.
+   * Returns \c false if \a text_r is the current text and nothing changed.
+   */
+  bool setLhs( const std::string & text_r, const char * suffix_r = "" );
+
+  /** The text passed to the last \ref setLhs. */
+  const std::string & lhsText() const
+  { return _text; }
+
+  /** Render the line for \a width_r with the percentage indicator for
+   * \a percent_r (if in [0,100]) and \a rhs_r of \a rhslen_r bytes.
+   * The returned reference is valid until the next call.
+   */
+  const std::string & render( unsigned width_r, int percent_r, const char * rhs_r, unsigned rhslen_r );
+
+private:
+  /** Byte offset of the first \a n_r utf8 characters of the lhs. */
+  std::string::size_type lhsPrefix( unsigned n_r );
+
+private:
+  char _exp;
+  bool _expand;			//< expand only if stdout is a tty
+  std::string _text;
+  std::string _lhs;
+  unsigned _llen;		//< utf8 size of _lhs
+  unsigned _prefixChars;	//< cached last lhsPrefix argument
+  std::string::size_type _prefixBytes;	//< and result
+  std::string _buf;
+};
+
 /**
  * Base class for producing common (for now) zypper output.
  *
@@ -283,6 +337,15 @@ public:
   virtual void dwnldProgressEnd(const zypp::Url & uri,
                                 long rate = -1,
                                 bool error = false) = 0;
+
+  /**
+   * Aggregate state of all in-flight downloads.
+   *
+   * The media callbacks register each download here before calling the
+   * dwnldProgress* methods, so implementations may render overall
+   * progress (files, bytes, rate, ETA) along with the current file.
+   */
+  DownloadSet & downloads() { return _downloads; }
   //@}
 
   /**
@@ -352,6 +415,7 @@ protected:
 private:
   Verbosity _verbosity;
   Type      _type;
+  DownloadSet _downloads;
 };
 
 ///////////////////////////////////////////////////////////////////
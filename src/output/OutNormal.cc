@@ -18,15 +18,49 @@
 
 #include "main.h"
 #include "utils/colors.h"
+#include "utils/console.h"
+#include "utils/misc.h"
 #include "AliveCursor.h"
 
 #include "OutNormal.h"
 
 using namespace std;
 
+namespace
+{
+  /** Min. time between two redraws of a changing progress line (ms). */
+  const unsigned long long progressFrameInterval = 100;
+  /** Min. time between two redraws of an unchanged progress line (ms),
+   * just turning the alive cursor. */
+  const unsigned long long progressAliveInterval = 250;
+
+  /** Append overall progress of a multi-file download like
+   * <tt>" (3/150, 34.5 MiB/120.0 MiB, 2.1 MiB/s, ETA 1:20)"</tt>. */
+  void appendDownloadSummary( zypp::str::Str & str_r, const DownloadSet & downloads_r )
+  {
+    str_r << " (" << downloads_r.filesDone() << '/' << downloads_r.filesExpected();
+    if ( downloads_r.bytesExpected() )
+      str_r << ", " << downloads_r.bytesDone() << '/' << downloads_r.bytesExpected();
+    if ( downloads_r.inFlight() > 1 && downloads_r.rate() > 0 )
+      str_r << ", " << zypp::ByteCount( downloads_r.rate() ) << "/s";
+    long eta = downloads_r.eta();
+    if ( eta >= 0 )
+    {
+      str_r << ", " << _("ETA") << ' ';
+      if ( eta >= 3600 )
+        str_r << zypp::str::form( "%ld:%02ld:%02ld", eta / 3600, eta / 60 % 60, eta % 60 );
+      else
+        str_r << zypp::str::form( "%ld:%02ld", eta / 60, eta % 60 );
+    }
+    str_r << ')';
+  }
+} // namespace
+
 OutNormal::OutNormal(Verbosity verbosity)
   : Out(TYPE_NORMAL, verbosity),
-    _use_colors(false), _isatty(isatty(STDOUT_FILENO)), _newline(true), _oneup(false)
+    _use_colors(false), _isatty(isatty(STDOUT_FILENO)), _newline(true), _oneup(false),
+    _lastFrame(0), _lastFramePercent(-1), _lastFrameWidth(0),
+    _progressLine('-')
 {}
 
 OutNormal::~OutNormal()
@@ -121,30 +155,46 @@ void OutNormal::error(const zypp::Exception & e,
 
 // ----------------------------------------------------------------------------
 
+bool OutNormal::progressFrameDue(const std::string & label, int percent)
+{
+  unsigned long long now = monotonic_ms();
+  unsigned width = termwidth();
+  bool changed = ( percent != _lastFramePercent
+                   || width != _lastFrameWidth
+                   || label != _lastFrameLabel );
+
+  if ( now - _lastFrame < ( changed ? progressFrameInterval : progressAliveInterval ) )
+    return false;
+
+  _lastFrame = now;
+  _lastFramePercent = percent;
+  _lastFrameWidth = width;
+  if ( changed )
+    _lastFrameLabel = label;
+  return true;
+}
+
+void OutNormal::resetProgressFrame()
+{
+  _lastFrame = 0;
+  _lastFramePercent = -1;
+  _lastFrameLabel.clear();
+}
+
+// ----------------------------------------------------------------------------
+
 void OutNormal::displayProgress (const string & s, int percent)
 {
   static AliveCursor cursor;
 
   if (_isatty)
   {
-    TermLine outstr( TermLine::SF_CRUSH | TermLine::SF_EXPAND, '-' );
-    outstr.lhs << s << ' ';
+    if ( ! progressFrameDue( s, percent ) )
+      return;
 
-    // dont display percents if invalid
-    if ( percent >= 0 && percent <= 100 )
-    {
-      outstr.percentHint = percent;
-    }
     ++cursor;
-    outstr.rhs << '[' << cursor.current() << ']';
-
-    if(_oneup)
-      cout << CLEARLN << CURSORUP(1);
-    cout << CLEARLN;
-
-    std::string outline( outstr.get( termwidth() ) );
-    cout << outline << std::flush;
-    // no _oneup if CRUSHed // _oneup = ( outline.length() > termwidth() );
+    // dont display percents if invalid
+    drawProgressLine( s, ( percent >= 0 && percent <= 100 ) ? percent : -1, cursor.current() );
   }
   else
     cout << '.' << std::flush;
@@ -158,18 +208,11 @@ void OutNormal::displayTick (const string & s)
 
   if (_isatty)
   {
-    TermLine outstr( TermLine::SF_CRUSH | TermLine::SF_EXPAND, '-' );
-    ++cursor;
-    outstr.lhs << s << ' ';
-    outstr.rhs << '[' << cursor.current() << ']';
-
-    if(_oneup)
-      cout << CLEARLN << CURSORUP(1);
-    cout << CLEARLN;
+    if ( ! progressFrameDue( s, -1 ) )
+      return;
 
-    std::string outline( outstr.get( termwidth() ) );
-    cout << outline << std::flush;
-    // no _oneup if CRUSHed // _oneup = ( outline.length() > termwidth() );
+    ++cursor;
+    drawProgressLine( s, -1, cursor.current() );
   }
   else
     cout << '.' << std::flush;
@@ -177,6 +220,22 @@ void OutNormal::displayTick (const string & s)
 
 // ----------------------------------------------------------------------------
 
+void OutNormal::drawProgressLine (const string & s, int percent, char cursor)
+{
+  // lhs is measured only if the label changed
+  _progressLine.setLhs( s, " " );
+  const char rhs[] = { '[', cursor, ']' };
+
+  if(_oneup)
+    cout << CLEARLN << CURSORUP(1);
+  cout << CLEARLN;
+
+  cout << _progressLine.render( termwidth(), percent, rhs, sizeof(rhs) ) << std::flush;
+  // no _oneup if CRUSHed // _oneup = ( outline.length() > termwidth() );
+}
+
+// ----------------------------------------------------------------------------
+
 void OutNormal::progressStart(const std::string & id,
                               const std::string & label,
                               bool is_tick)
@@ -187,6 +246,7 @@ void OutNormal::progressStart(const std::string & id,
   if (!_isatty)
     cout << label << " [";
 
+  resetProgressFrame();
   if (is_tick)
     displayTick(label);
   else
@@ -213,6 +273,7 @@ void OutNormal::progressEnd(const std::string & id, const string & label, bool e
   if (progressFilter())
     return;
 
+  resetProgressFrame();
   if (!error && _use_colors)
     cout << get_color(COLOR_CONTEXT_MSG_STATUS);
 
@@ -260,6 +321,7 @@ void OutNormal::dwnldProgressStart(const zypp::Url & uri)
 
   if (_isatty)
     cout << CLEARLN;
+  resetProgressFrame();
 
   TermLine outstr( TermLine::SF_CRUSH | TermLine::SF_EXPAND, '-' );
   outstr.lhs << _("Retrieving:") << ' ';
@@ -287,12 +349,16 @@ void OutNormal::dwnldProgress(const zypp::Url & uri,
   if (verbosity() < NORMAL)
     return;
 
-  if (!isatty(STDOUT_FILENO))
+  if (!_isatty)
   {
     cout << '.' << std::flush;
     return;
   }
 
+  // a changing rate alone is redrawn at the alive cursor interval
+  if ( ! progressFrameDue( uri.asString(), value ) )
+    return;
+
   if(_oneup)
     cout << CLEARLN << CURSORUP(1);
   cout << CLEARLN;
@@ -303,7 +369,9 @@ void OutNormal::dwnldProgress(const zypp::Url & uri,
     outstr.lhs << uri;
   else
     outstr.lhs << zypp::Pathname(uri.getPathName()).basename();
-   outstr.lhs << ' ';
+  if ( downloads().inFlight() > 1 )
+    outstr.lhs << " (+" << downloads().inFlight() - 1 << ")";
+  outstr.lhs << ' ';
 
   // dont display percents if invalid
   if ( value >= 0 && value <= 100 )
@@ -315,6 +383,8 @@ void OutNormal::dwnldProgress(const zypp::Url & uri,
   if (rate > 0 )
     outstr.rhs << " (" << zypp::ByteCount(rate) << "/s)";
   outstr.rhs << ']';
+  if ( downloads().aggregate() )
+    appendDownloadSummary( outstr.rhs, downloads() );
 
   std::string outline( outstr.get( termwidth() ) );
   cout << outline << std::flush;
@@ -327,6 +397,7 @@ void OutNormal::dwnldProgressEnd(const zypp::Url & uri, long rate, bool error)
   if (verbosity() < NORMAL)
     return;
 
+  resetProgressFrame();
   if (!error && _use_colors)
     cout << get_color(COLOR_CONTEXT_MSG_STATUS);
 
@@ -423,12 +494,6 @@ void OutNormal::promptHelp(const PromptOptions & poptions)
 unsigned int OutNormal::termwidth() const {
   if(!_isatty)
     return 10000;
-  else
-  {
-    struct winsize wns;
-    if (!ioctl(1, TIOCGWINSZ, &wns))
-      return wns.ws_col;
-    else
-      return 10000;
-  }
+  // cached, updated on SIGWINCH
+  return get_screen_width();
 }
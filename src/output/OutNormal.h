@@ -84,6 +84,15 @@ private:
   bool infoWarningFilter(Verbosity verbosity, Type mask);
   void displayProgress(const std::string & s, int percent);
   void displayTick(const std::string & s);
+  /* Draw the self-overwriting progress line with \a s, the percentage
+   * indicator (unless \a percent is -1) and the alive \a cursor. */
+  void drawProgressLine(const std::string & s, int percent, char cursor);
+  /* Whether a self-overwriting progress line showing \a label at \a percent
+   * should be redrawn now. Redraws are coalesced to a fixed frame rate and
+   * unchanged lines are only redrawn to turn the alive cursor. */
+  bool progressFrameDue(const std::string & label, int percent);
+  /* Make the next \ref progressFrameDue return true. */
+  void resetProgressFrame();
   /* Return current terminal width
    * or return 10000 when failed */
   unsigned int termwidth() const;
@@ -95,6 +104,16 @@ private:
   bool _newline;
   /* True if the last output line was longer than the terminal width */
   bool _oneup;
+
+  /* Time (ms) the last progress line was drawn, its label, percentage
+   * and the terminal width used. */
+  unsigned long long _lastFrame;
+  std::string _lastFrameLabel;
+  int _lastFramePercent;
+  unsigned _lastFrameWidth;
+
+  /* Layout of the progress line, reused for each tick. */
+  TermLineLayout _progressLine;
 };
 
 #endif /*OUTNORMAL_H_*/
@@ -186,6 +186,22 @@ void OutXML::dwnldProgressEnd(const zypp::Url & uri, long rate, bool error)
     << " rate=\"" << rate << "\""
     << " done=\"" << error << "\""
     << "/>" << endl;
+
+  // overall progress of a multi-file download
+  const DownloadSet & set( downloads() );
+  if ( set.aggregate() )
+  {
+    cout << "<download-summary"
+      << " files-done=\"" << set.filesDone() << "\""
+      << " files-failed=\"" << set.filesFailed() << "\""
+      << " files-total=\"" << set.filesExpected() << "\""
+      << " in-flight=\"" << set.inFlight() << "\""
+      << " bytes-done=\"" << ((zypp::ByteCount::SizeType) set.bytesDone()) << "\""
+      << " bytes-total=\"" << ((zypp::ByteCount::SizeType) set.bytesExpected()) << "\""
+      << " rate=\"" << set.rate() << "\""
+      << " eta=\"" << set.eta() << "\""
+      << "/>" << endl;
+  }
 }
 
 void OutXML::searchResult( const Table & table_r )
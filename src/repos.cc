@@ -31,6 +31,10 @@
 #include "Table.h"
 #include "utils/messages.h"
 #include "utils/misc.h" // for xml_encode
+#include "PackageCache.h"
+#include "PoolWatcher.h"
+#include "Profiler.h"
+#include "RepoIndex.h"
 #include "repos.h"
 
 using namespace std;
@@ -177,6 +181,7 @@ static bool refresh_raw_metadata(Zypper & zypper,
 
         origRepo.setEnabled(false);
         manager.modifyRepository(repo.alias(), origRepo);
+        zypper.reposChanged();
       }
       catch (const Exception & ex)
       {
@@ -344,104 +349,19 @@ static bool build_cache(Zypper & zypper, const RepoInfo &repo, bool force_build)
 
 bool match_repo(Zypper & zypper, string str, RepoInfo *repo)
 {
-  RepoManager & manager = zypper.repoManager();
-
-  // Quick check for alias/reponumber/name first.
-  // Name can be ambiguous, in which case the first match found will be returned
-  {
-    unsigned int number = 1; // repo number
-    unsigned int tmp    = 0;
-    safe_lexical_cast (str, tmp); // try to make an int out of the string
-    for (RepoManager::RepoConstIterator known_it = manager.repoBegin();
-         known_it != manager.repoEnd(); ++known_it, ++number)
-    {
-      if (known_it->alias() == str || tmp == number || known_it->name() == str)
-      {
-        if (repo)
-          *repo = *known_it;
-
-        return true;
-      }
-    }
-  }
-
-  // expensive URL analysis only if the above did not find anything.
-  // URL can be ambiguous, in which case the first found match will be returned.
-  bool found = false;
-
-  for (RepoManager::RepoConstIterator known_it = manager.repoBegin();
-       known_it != manager.repoEnd(); ++known_it)
-  {
-    try
-    {
-      // first strip any trailing slash from the path in URLs before comparing
-      // (bnc #585082)
-      // we can afford this because we expect that the repo urls are directories
-      // and it is common practice in servers and operating systems to accept
-      // directory paths both with and without trailing slashes.
-      Url uurl(str);
-      uurl.setPathName(Pathname(uurl.getPathName()).asString());
-
-      url::ViewOption urlview =
-          url::ViewOption::DEFAULTS + url::ViewOption::WITH_PASSWORD;
-      if (zypper.cOpts().count("loose-auth"))
-      {
-        urlview = urlview
-            - url::ViewOptions::WITH_PASSWORD
-            - url::ViewOptions::WITH_USERNAME;
-      }
-      if (zypper.cOpts().count("loose-query"))
-        urlview = urlview - url::ViewOptions::WITH_QUERY_STR;
-
-      // need to do asString(withurlview) comparison here because the user-given
-      // string is expected to have no credentials or query
-      if (!(urlview.has(url::ViewOptions::WITH_PASSWORD)
-            && urlview.has(url::ViewOptions::WITH_QUERY_STR)))
-      {
-        if (!known_it->baseUrlsEmpty())
-        {
-          for_(urlit, known_it->baseUrlsBegin(), known_it->baseUrlsEnd())
-          {
-            Url newrl(*urlit);
-            newrl.setPathName(Pathname(newrl.getPathName()).asString());
-            if (newrl.asString(urlview) == uurl.asString(urlview))
-            {
-              found = true;
-              break;
-            }
-          }
-        }
-      }
-      // ordinary == comparison suffices here (quicker)
-      else
-      {
-        if (!known_it->baseUrlsEmpty())
-        {
-          for_(urlit, known_it->baseUrlsBegin(), known_it->baseUrlsEnd())
-          {
-            Url newrl(*urlit);
-            newrl.setPathName(Pathname(newrl.getPathName()).asString());
-            if (newrl == uurl)
-            {
-              found = true;
-              break;
-            }
-          }
-        }
-      }
-
-      if (found)
-      {
-        if (repo)
-          *repo = *known_it;
-        break;
-      }
-    }
-    catch(const url::UrlException &){}
-
-  } // END for all known repos
-
-  return found;
+  // Alias, number and name are checked first, URLs only if none of them
+  // matches. Name and URL can be ambiguous, in which case the first match
+  // found is returned.
+  url::ViewOption urlview = RepoIndex::urlView(
+      zypper.cOpts().count("loose-auth"), zypper.cOpts().count("loose-query"));
+
+  RepoInfo found;
+  if (!zypper.repoIndex().find(str, urlview, found))
+    return false;
+
+  if (repo)
+    *repo = found;
+  return true;
 }
 
 // ---------------------------------------------------------------------------
@@ -637,7 +557,9 @@ void do_init_repos(Zypper & zypper, const Container & container)
     for (list<RepoInfo>::iterator it = gData.additional_repos.begin();
         it != gData.additional_repos.end(); ++it)
     {
-      add_repo(zypper, *it);
+      // added already if the shell initializes the repos once more
+      if (!manager.hasRepo(*it))
+        add_repo(zypper, *it);
       gData.repos.push_back(*it);
     }
   }
@@ -767,29 +689,75 @@ void init_repos(Zypper & zypper)
 { init_repos(zypper, std::vector<std::string>()); }
 
 
+/** Remove the repos initialized for a previous shell command from the pool,
+ * so that the next init_repos() starts anew. */
+static void unload_repos(Zypper & zypper)
+{
+  RuntimeData & gData = zypper.runtimeData();
+  const sat::Pool & satpool(sat::Pool::instance());
+  for_(it, gData.repos.begin(), gData.repos.end())
+  {
+    Repository robj = satpool.reposFind(it->alias());
+    if (robj != Repository::noRepository)
+      robj.eraseFromPool();
+  }
+  MIL << "Unloaded " << gData.repos.size() << " repos" << endl;
+
+  gData.repos.clear();
+  gData.repos_initialized = false;
+  gData.repos_loaded = false;
+  gData.repos_selection.clear();
+  if (gData.pool_watcher)
+    gData.pool_watcher->forgetRepos();
+}
+
+std::string repos_selection(const parsed_opts & copts_r, const std::vector<std::string> & repos_r)
+{
+  // the same repos as do_init_repos() gets
+  std::vector<std::string> specs;
+  parsed_opts::const_iterator it;
+  if ((it = copts_r.find("repo")) != copts_r.end())
+    specs.insert(specs.end(), it->second.begin(), it->second.end());
+  if ((it = copts_r.find("catalog")) != copts_r.end())
+    specs.insert(specs.end(), it->second.begin(), it->second.end());
+  specs.insert(specs.end(), repos_r.begin(), repos_r.end());
+  return str::join(specs.begin(), specs.end(), "\n");
+}
+
 template <typename Container>
 void init_repos(Zypper & zypper, const Container & container)
 {
-  static bool done = false;
-  //! \todo this has to be done so that it works in zypper shell
-  if (done)
-    return;
+  RuntimeData & gData = zypper.runtimeData();
+  // the shell keeps the repos of the previous command unless they changed
+  // (see reload_changed_pool()) or this one wants other ones
+  std::string selection(repos_selection(copts,
+      std::vector<std::string>(container.begin(), container.end())));
+  if (gData.repos_initialized)
+  {
+    if (selection == gData.repos_selection)
+      return;
+    unload_repos(zypper);
+  }
 
+  Profiler::Span span("init repos");
   if ( !zypper.globalOpts().disable_system_sources )
     do_init_repos(zypper, container);
+  if (gData.pool_watcher)
+    gData.pool_watcher->rememberReposConfig();
 
-  done = true;
+  gData.repos_initialized = true;
+  gData.repos_selection = selection;
 }
 
 // ----------------------------------------------------------------------------
 
 void init_target (Zypper & zypper)
 {
-  static bool done = false;
-  if (!done)
+  if (!zypper.runtimeData().target_initialized)
   {
     zypper.out().info(_("Initializing Target"), Out::HIGH);
     MIL << "Initializing target" << endl;
+    Profiler::Span span("init target");
 
     try
     {
@@ -808,7 +776,7 @@ void init_target (Zypper & zypper)
         "Target initialization failed: " + e.msg());
     }
 
-    done = true;
+    zypper.runtimeData().target_initialized = true;
   }
 }
 
@@ -1354,6 +1322,41 @@ bool refresh_repo(Zypper & zypper, const zypp::RepoInfo & repo)
 
 // ----------------------------------------------------------------------------
 
+void limit_package_cache(Zypper & zypper, Out::Verbosity verbosity,
+                         time_t keepSince)
+{
+  const Config & config(zypper.config());
+  PackageCache cache(zypper.globalOpts().rm_options.repoPackagesCachePath);
+
+  if (config.cache_packagesBudget || config.cache_packagesMaxAge)
+  {
+    PackageCache::Eviction evicted = cache.enforce(
+        config.cache_packagesBudget, config.cache_packagesMaxAge, keepSince);
+    if (!config.cache_packagesStore.empty())
+    {
+      // same limits for the store; what the caches still link stays on disk
+      PackageCache::Eviction store = PackageCache(config.cache_packagesStore)
+        .enforce(config.cache_packagesBudget, config.cache_packagesMaxAge, keepSince);
+      evicted.files += store.files;
+      evicted.bytes += store.bytes;
+    }
+    zypper.out().info(boost::str(format(
+        // translators: e.g. Removed 12 packages (30.2 MiB) from the package cache, 1.0 GiB left.
+        _PL("Removed %u package (%s) from the package cache, %s left.",
+            "Removed %u packages (%s) from the package cache, %s left.",
+            evicted.files))
+        % evicted.files % evicted.bytes % evicted.left), verbosity);
+  }
+
+  const PackageCache::Stats & stats(cache.stats());
+  if (stats.hitRate() < 0)
+    return;
+  zypper.out().info(boost::str(format(
+      // translators: e.g. Package cache hit rate: 40% (120 of 300 packages), 320.5 MiB not downloaded again.
+      _("Package cache hit rate: %d%% (%llu of %llu packages), %s not downloaded again."))
+      % stats.hitRate() % stats.hits % (stats.hits + stats.misses) % stats.saved), verbosity);
+}
+
 void clean_repos(Zypper & zypper)
 {
   RepoManager & manager = zypper.repoManager();
@@ -1595,6 +1598,7 @@ void add_repo(Zypper & zypper, RepoInfo & repo)
     struct Bye { ~Bye() { Zypper::instance()->runtimeData().current_repo = RepoInfo(); } } reset __attribute__ ((__unused__));
 
     manager.addRepository(repo);
+    zypper.reposChanged();
     repo = manager.getRepo(repo);
   }
   catch (const RepoInvalidAliasException & e)
@@ -1852,6 +1856,7 @@ void remove_repo(Zypper & zypper, const RepoInfo & repoinfo)
 {
   RepoManager & manager = zypper.repoManager();
   manager.removeRepository(repoinfo);
+  zypper.reposChanged();
   zypper.out().info(boost::str(
     format(_("Repository '%s' has been removed."))
       % (zypper.config().show_alias ? repoinfo.alias() : repoinfo.name())));
@@ -1882,6 +1887,7 @@ void rename_repo(Zypper & zypper,
 
     repo.setAlias(newalias);
     manager.modifyRepository(alias, repo);
+    zypper.reposChanged();
 
     zypper.out().info(boost::str(format(
       _("Repository '%s' renamed to '%s'.")) % alias % repo.alias()));
@@ -2075,6 +2081,7 @@ void modify_repo(Zypper & zypper, const string & alias)
         || changed_keeppackages || changed_gpgcheck || !name.empty())
     {
       manager.modifyRepository(alias, repo);
+      zypper.reposChanged();
 
       if (chnaged_enabled)
       {
@@ -2640,6 +2647,7 @@ void add_service(Zypper & zypper, const ServiceInfo & service)
   try
   {
     manager.addService(service);
+    zypper.reposChanged();
   }
   catch (const RepoAlreadyExistsException & e)
   {
@@ -2704,6 +2712,7 @@ void remove_service(Zypper & zypper, const ServiceInfo & service)
     format(_("Removing service '%s':"))
       % (zypper.config().show_alias ? service.alias() : service.name())));
   manager.removeService(service);
+  zypper.reposChanged();
   zypper.out().info(boost::str(
     format(_("Service '%s' has been removed."))
       % (zypper.config().show_alias ? service.alias() : service.name())));
@@ -2725,6 +2734,7 @@ static bool refresh_service(Zypper & zypper, const ServiceInfo & service)
         str::form(_("Refreshing service '%s'."),
           (zypper.config().show_alias ? service.alias().c_str() : service.name().c_str())));
     manager.refreshService(service);
+    zypper.reposChanged();
     error = false;
   }
   catch ( const repo::ServicePluginInformalException & e )
@@ -3006,6 +3016,7 @@ void modify_service(Zypper & zypper, const string & alias)
         || !rrtodisable.empty())
     {
       manager.modifyService(alias, srv);
+      zypper.reposChanged();
 
       if (chnaged_enabled)
       {
@@ -3161,19 +3172,27 @@ void modify_services_by_option( Zypper & zypper )
 
 void load_resolvables(Zypper & zypper)
 {
-  static bool done = false;
-  // don't call this fuction more than once for a single ZYpp instance
-  // (e.g. in shell)
-  if (done)
+  RuntimeData & gData = zypper.runtimeData();
+  // don't load anything twice for a single ZYpp instance (e.g. in shell),
+  // reload_changed_pool() takes care of the changes
+  bool load_target =
+    !zypper.globalOpts().disable_system_resolvables && !gData.target_loaded;
+  // nor what the command does not need (a later one in the shell may)
+  if (load_target && zypper.commandLoadFlags().testFlag(Zypper::NO_TARGET))
+  {
+    MIL << "Command does not need the installed packages, not reading them" << endl;
+    load_target = false;
+  }
+  if (gData.repos_loaded && !load_target)
     return;
 
   MIL << "Going to load resolvables" << endl;
 
-  load_repo_resolvables(zypper);
-  if (!zypper.globalOpts().disable_system_resolvables)
+  if (!gData.repos_loaded)
+    load_repo_resolvables(zypper);
+  if (load_target)
     load_target_resolvables(zypper);
 
-  done = true;
   MIL << "Done loading resolvables" << endl;
 }
 
@@ -3185,6 +3204,7 @@ void load_repo_resolvables(Zypper & zypper)
   RuntimeData & gData = zypper.runtimeData();
 
   zypper.out().info(_("Loading repository data..."));
+  Profiler::Span span("load repos");
 
   for (std::list<RepoInfo>::iterator it = gData.repos.begin();
        it !=  gData.repos.end(); ++it)
@@ -3199,6 +3219,7 @@ void load_repo_resolvables(Zypper & zypper)
       continue;     // #217297
     }
 
+    Profiler::Span repo_span("load repo", repo.alias());
     try
     {
       bool error = false;
@@ -3239,6 +3260,8 @@ void load_repo_resolvables(Zypper & zypper)
       }
 
       manager.loadFromCache(repo);
+      if (gData.pool_watcher)
+        gData.pool_watcher->rememberRepo(repo);
 
       // check that the metadata is not outdated
       // feature #301904
@@ -3274,6 +3297,7 @@ void load_repo_resolvables(Zypper & zypper)
           % (zypper.config().show_alias ? repo.alias() : repo.name())));
     }
   }
+  gData.repos_loaded = true;
 }
 
 // ---------------------------------------------------------------------------
@@ -3282,10 +3306,15 @@ void load_target_resolvables(Zypper & zypper)
 {
   zypper.out().info(_("Reading installed packages..."));
   MIL << "Going to read RPM database" << endl;
+  Profiler::Span span("load target");
 
   try
   {
     God->target()->load();
+    RuntimeData & gData = zypper.runtimeData();
+    gData.target_loaded = true;
+    if (gData.pool_watcher)
+      gData.pool_watcher->rememberTarget();
   }
   catch ( const Exception & e )
   {
@@ -3299,6 +3328,55 @@ void load_target_resolvables(Zypper & zypper)
 
 // ---------------------------------------------------------------------------
 
+void reload_changed_pool(Zypper & zypper)
+{
+  RuntimeData & gData = zypper.runtimeData();
+  if (!gData.pool_watcher)
+    return;
+  PoolWatcher & watcher(*gData.pool_watcher);
+
+  // repos added, removed or modified: initialize them anew
+  if (gData.repos_initialized && watcher.reposConfigChanged())
+  {
+    MIL << "Repository definitions changed" << endl;
+    unload_repos(zypper);
+  }
+  // refreshed repos: just load their new solv files
+  else if (gData.repos_loaded)
+  {
+    std::vector<std::string> changed(watcher.changedRepos());
+    for_(alias, changed.begin(), changed.end())
+    {
+      for_(it, gData.repos.begin(), gData.repos.end())
+      {
+        if (it->alias() != *alias)
+          continue;
+        MIL << "Reloading changed repo " << *alias << endl;
+        try
+        {
+          zypper.repoManager().loadFromCache(*it);
+          watcher.rememberRepo(*it);
+        }
+        catch (const Exception & e)
+        {
+          ZYPP_CAUGHT(e);
+          zypper.out().error(e,
+              boost::str(format(_("Problem loading data from '%s'"))
+                  % (zypper.config().show_alias ? it->alias() : it->name())));
+        }
+        break;
+      }
+    }
+  }
+
+  if (gData.target_loaded && watcher.targetChanged())
+  {
+    MIL << "RPM database changed" << endl;
+    God->target()->reload();
+    watcher.rememberTarget();
+  }
+}
+
 // ----------------------------------------------------------------------------
 
 // #217028
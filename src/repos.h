@@ -9,6 +9,7 @@
 #define ZMART_SOURCES_H
 
 #include <list>
+#include <vector>
 
 #include <zypp/TriBool.h>
 #include <zypp/Url.h>
@@ -28,6 +29,13 @@
 template <typename Container>
 void init_repos(Zypper & zypper, const Container & container = Container());
 
+/**
+ * The repos selected by --repo or --catalog in \a copts_r and by
+ * \a repos_r (the container of \ref init_repos()). In the shell, the repos
+ * are initialized anew if the selection differs from the last command's.
+ */
+std::string repos_selection(const parsed_opts & copts_r, const std::vector<std::string> & repos_r);
+
 template<typename T>
 void get_repos(Zypper & zypper,
                const T & begin, const T & end,
@@ -88,6 +96,14 @@ bool refresh_repo(Zypper & zypper, const zypp::RepoInfo & repo);
  */
 void clean_repos(Zypper & zypper);
 
+/**
+ * Evict packages from the package caches according to the limits set in
+ * zypper.conf (cache.packagesBudget, cache.packagesMaxAge) and report the
+ * cache's hit rate. Packages used since \a keepSince are kept.
+ */
+void limit_package_cache(Zypper & zypper, Out::Verbosity verbosity,
+                         time_t keepSince = 0);
+
 /**
  * Try match given string with any known repository.
  *
@@ -214,6 +230,15 @@ void load_target_resolvables(Zypper & zypper);
  */
 void load_repo_resolvables(Zypper & zypper);
 
+/**
+ * Bring the pool kept by the zypper shell up to date before the next command:
+ * initialize the repos anew if their definitions changed, reload the repos
+ * whose solv cache changed, and the target if the rpm database changed.
+ *
+ * \see PoolWatcher
+ */
+void reload_changed_pool(Zypper & zypper);
+
 
 /**
  * If ZMD process found, notify user that ZMD is running and that changes
@@ -7,6 +7,8 @@
 
 #include <iostream>
 #include <sstream>
+#include <set>
+#include <algorithm>
 #include <boost/format.hpp>
 
 #include <zypp/ZYppFactory.h>
@@ -14,9 +16,11 @@
 #include <zypp/FileChecker.h>
 #include <zypp/base/InputStream.h>
 #include <zypp/base/IOStream.h>
+#include <zypp/PathInfo.h>
 
 #include <zypp/media/MediaException.h>
 #include <zypp/misc/CheckAccessDeleted.h>
+#include <zypp/sat/Pool.h>
 
 #include "misc.h"              // confirm_licenses
 #include "repos.h"              // get_repo - used in dist_upgrade
@@ -24,6 +28,14 @@
 #include "utils/prompt.h"      // Continue? and solver problem prompt
 #include "utils/pager.h"       // to view the summary
 #include "Summary.h"
+#include "Table.h"
+#include "PackagePrefetcher.h"
+#include "PackageCache.h"
+#include "PackageStore.h"
+#include "DeletedFilesScanner.h"
+#include "Profiler.h"
+#include "SolutionCache.h"
+#include "UpdateCandidates.h"
 
 #include "solve-commit.h"
 
@@ -214,7 +226,7 @@ static void dump_pool ()
 }
 
 
-static void set_force_resolution(Zypper & zypper)
+static void set_force_resolution(Zypper & zypper, bool report)
 {
   // --force-resolution command line parameter value
   TriBool force_resolution = zypper.runtimeData().force_resolution;
@@ -223,7 +235,7 @@ static void set_force_resolution(Zypper & zypper)
     force_resolution = true;
   if (zypper.cOpts().count("no-force-resolution"))
   {
-    if (force_resolution)
+    if (force_resolution && report)
       zypper.out().warning(str::form(
         // translators: meaning --force-resolution and --no-force-resolution
         _("%s conflicts with %s, will use the less aggressive %s"),
@@ -256,9 +268,12 @@ static void set_force_resolution(Zypper & zypper)
   zypper.runtimeData().force_resolution = force_resolution;
 
   DBG << "force resolution: " << force_resolution << endl;
-  ostringstream s;
-  s << _("Force resolution:") << " " << (force_resolution ? _("Yes") : _("No"));
-  zypper.out().info(s.str(), Out::HIGH);
+  if (report)
+  {
+    ostringstream s;
+    s << _("Force resolution:") << " " << (force_resolution ? _("Yes") : _("No"));
+    zypper.out().info(s.str(), Out::HIGH);
+  }
 
   God->resolver()->setForceResolve(force_resolution);
 }
@@ -305,9 +320,11 @@ static void set_ignore_recommends_of_installed(Zypper & zypper)
 }
 
 
-static void set_solver_flags(Zypper & zypper)
+/** Set up the resolver for the command. The settings are reported to the
+ * user unless \a report is false (already done, or yet to be done). */
+static void set_solver_flags(Zypper & zypper, bool report = true)
 {
-  set_force_resolution(zypper);
+  set_force_resolution(zypper, report);
   set_clean_deps(zypper);
   set_no_recommends(zypper);
   set_ignore_recommends_of_installed(zypper);
@@ -321,25 +338,31 @@ static void set_solver_flags(Zypper & zypper)
  */
 bool resolve(Zypper & zypper)
 {
+  Profiler::Span span("solve");
   dump_pool(); // debug
   set_solver_flags(zypper);
   DBG << "Calling the solver..." << endl;
+  UpdateCandidates::instance().patchStatusChanged();
   return God->resolver()->resolvePool();
 }
 
 static bool verify(Zypper & zypper)
 {
+  Profiler::Span span("solve", "verify");
   dump_pool();
   set_solver_flags(zypper);
   zypper.out().info(_("Verifying dependencies..."), Out::HIGH);
   DBG << "Calling the solver to verify system..." << endl;
+  UpdateCandidates::instance().patchStatusChanged();
   return God->resolver()->verifySystem();
 }
 
 static bool dist_upgrade(Zypper & zypper)
 {
+  Profiler::Span span("solve", "dist-upgrade");
   dump_pool();
   set_solver_flags(zypper);
+  UpdateCandidates::instance().patchStatusChanged();
 
   // Test for repositories to upgrade to (--from)
   // If those are specified addUpgradeRepo and solve,
@@ -386,11 +409,12 @@ static bool dist_upgrade(Zypper & zypper)
  * (like doUpdate(), doUpgrade(), verify(), and resolve()) to generate
  * solver testcase.
  */
+static const char * testcase_dir = "/var/log/zypper.solverTestCase";
+
 static void make_solver_test_case(Zypper & zypper)
 {
 //  set_solver_flags(zypper);
 
-  string testcase_dir("/var/log/zypper.solverTestCase");
 
   zypper.out().info(_("Generating solver test case..."));
   if (God->resolver()->createSolverTestcase(testcase_dir))
@@ -404,6 +428,82 @@ static void make_solver_test_case(Zypper & zypper)
   }
 }
 
+/** The command line as far as the solver is concerned (solution cache). */
+static string solver_request(Zypper & zypper)
+{
+  // options not affecting the solution
+  static const char * ignored[] = {
+    "debug-solver", "dry-run", "auto-agree-with-licenses",
+    "download", "download-only", "download-in-advance", "download-in-heaps",
+    "download-as-needed"
+  };
+
+  ostringstream s;
+  s << zypper.command().asString();
+  for_(it, zypper.arguments().begin(), zypper.arguments().end())
+    s << " " << *it;
+  for_(it, zypper.cOpts().begin(), zypper.cOpts().end())
+  {
+    if (std::find(ignored, ignored + sizeof(ignored)/sizeof(*ignored), it->first)
+        != ignored + sizeof(ignored)/sizeof(*ignored))
+      continue;
+    s << " --" << it->first;
+    for_(val, it->second.begin(), it->second.end())
+      s << "=" << *val;
+  }
+  s << " installRecommends=" << zypper.config().solver_installRecommends;
+  return s.str();
+}
+
+/**
+ * Compare the cached solution for \a fingerprint with the one the solver
+ * just computed, and add it to the solver test case (--debug-solver).
+ */
+static void replay_cached_solution(Zypper & zypper, const SolutionCache & cache,
+                                   const string & fingerprint)
+{
+  SolutionCache::Steps cached;
+  if (!cache.load(fingerprint, cached))
+  {
+    zypper.out().info(boost::str(format(
+        _("No cached solution for this request (%s).")) % fingerprint));
+    return;
+  }
+  filesystem::copy(cache.entryPath(fingerprint), Pathname(testcase_dir) / "zypper-solution");
+
+  set<string> cachedSteps;
+  for_(it, cached.begin(), cached.end())
+    cachedSteps.insert(it->asString());
+  SolutionCache::Steps solved(SolutionCache::transaction(God->pool()));
+  set<string> solvedSteps;
+  for_(it, solved.begin(), solved.end())
+    solvedSteps.insert(it->asString());
+
+  unsigned onlyCached = 0;
+  for_(it, cachedSteps.begin(), cachedSteps.end())
+    if (!solvedSteps.count(*it))
+    {
+      DBG << "only cached: " << *it << endl;
+      ++onlyCached;
+    }
+  unsigned onlySolved = 0;
+  for_(it, solvedSteps.begin(), solvedSteps.end())
+    if (!cachedSteps.count(*it))
+    {
+      DBG << "only solved: " << *it << endl;
+      ++onlySolved;
+    }
+
+  if (!onlyCached && !onlySolved)
+    zypper.out().info(boost::str(format(
+        _("The cached solution %s matches the solver's.")) % fingerprint));
+  else
+    zypper.out().warning(boost::str(format(
+        _("The cached solution %s differs from the solver's:"
+          " %u steps are cached only, %u are solved only.")) % fingerprint
+        % onlyCached % onlySolved));
+}
+
 ZYppCommitPolicy get_commit_policy(Zypper & zypper)
 {
   ZYppCommitPolicy policy;
@@ -428,24 +528,19 @@ ZYppCommitPolicy get_commit_policy(Zypper & zypper)
 /** fate #300763
  * This is called after each commit to notify user about running processes that
  * use libraries or other files that have been removed since their execution.
+ * Only the \a removed_files of the commit are looked for; all the others
+ * were deleted before and 'zypper ps' told about them already.
  */
-static void notify_processes_using_deleted_files(Zypper & zypper)
+static void notify_processes_using_deleted_files(
+    Zypper & zypper, const DeletedFilesScanner::Files & removed_files)
 {
   zypper.out().info(
       _("Checking for running processes using deleted libraries..."), Out::HIGH);
-  zypp::CheckAccessDeleted checker(false); // wait for explicit call to check()
-  try
-  {
-    checker.check();
-  }
-  catch(const zypp::Exception & e)
-  {
-    if (zypper.out().verbosity() > Out::NORMAL)
-      zypper.out().error(e, _("Check failed:"));
-  }
+  DeletedFilesScanner scanner;
+  scanner.restrictTo(removed_files);
 
-  // Don't suggest "zypper ps" if zypper is the only prog with deleted open files.
-  if (checker.size() > 1 || (checker.size() == 1 && checker.begin()->pid != zypp::str::numstring(::getpid())))
+  // zypper itself is not reported
+  if (!scanner.scan().empty())
   {
     zypper.out().info(str::form(
         _("There are some running programs that use files deleted by recent upgrade."
@@ -454,6 +549,133 @@ static void notify_processes_using_deleted_files(Zypper & zypper)
   }
 }
 
+/** Breakdown of the time needed to compute the summary (--timings). */
+static void show_summary_timings(Zypper & zypper, const Summary & summary)
+{
+  ostringstream s;
+  unsigned long long total = 0;
+  s << _("Time spent computing the summary:");
+  for_(it, summary.timings().begin(), summary.timings().end())
+  {
+    s << endl << format("  %-12s %8.1f ms") % it->first % (it->second / 1000.0);
+    total += it->second;
+  }
+  s << endl << format("  %-12s %8.1f ms") % _("total") % (total / 1000.0);
+  zypper.out().info(s.str());
+}
+
+///////////////////////////////////////////////////////////////////
+/// \class SolverStats
+/// \brief What the solver passes of solve_and_commit() did (--solver-stats).
+///////////////////////////////////////////////////////////////////
+class SolverStats
+{
+public:
+  SolverStats() : _round(0) {}
+
+  /** A solver pass of type \a type_r starts. */
+  void start(const string & type_r)
+  {
+    Pass pass;
+    pass.type = type_r;
+    pass.jobs = countJobs();
+    _passes.push_back(pass);
+    _started = monotonic_us();
+  }
+
+  /** The pass started last finished with \a success_r. */
+  void done(bool success_r)
+  {
+    Pass & pass(_passes.back());
+    pass.us = monotonic_us() - _started;
+    pass.success = success_r;
+    if (success_r)
+      pass.transaction = God->resolver()->getTransaction().actionSize();
+    else
+      pass.problems = God->resolver()->problems().size();
+  }
+
+  /** Another round of solving and committing starts, forget the passes
+   * of the previous one (they have been shown). */
+  void nextRound()
+  { ++_round; _passes.clear(); }
+
+  /** Show the passes of the current round. */
+  void show(Zypper & zypper) const
+  {
+    const sat::Pool & pool(sat::Pool::instance());
+    if (zypper.out().type() == Out::TYPE_XML)
+    {
+      cout << "<solver-stats solvables=\"" << pool.solvablesSize()
+           << "\" repos=\"" << pool.reposSize()
+           << "\" round=\"" << _round << "\">" << endl;
+      for_(it, _passes.begin(), _passes.end())
+        cout << "<pass type=\"" << it->type
+             << "\" time-us=\"" << it->us
+             << "\" jobs=\"" << it->jobs
+             << "\" success=\"" << it->success
+             << "\" problems=\"" << it->problems
+             << "\" transaction-size=\"" << it->transaction << "\"/>" << endl;
+      cout << "</solver-stats>" << endl;
+      return;
+    }
+
+    Table t;
+    TableHeader th;
+    // translators: table headers of the solver statistics (--solver-stats)
+    th << "#" << _("Pass") << _("Time (ms)") << _("Jobs") << _("Result") << _("Transaction");
+    t << th;
+    unsigned n = 0;
+    for_(it, _passes.begin(), _passes.end())
+    {
+      TableRow tr;
+      tr << str::numstring(++n) << it->type << str::form("%.1f", it->us / 1000.0)
+         << str::numstring(it->jobs)
+         << (it->success ? string(_("solved"))
+             : str::form(_PL("%u problem", "%u problems", it->problems), it->problems))
+         << (it->success ? str::numstring(it->transaction) : string());
+      t << tr;
+    }
+
+    zypper.out().info(str::form(
+        // translators: e.g. Solver statistics: 35124 solvables in 6 repositories, round 2.
+        _("Solver statistics: %u solvables in %u repositories, round %u."),
+        pool.solvablesSize(), pool.reposSize(), _round));
+    cout << t;
+  }
+
+private:
+  /** Transactions requested by the user or the application, and locks. */
+  static unsigned countJobs()
+  {
+    unsigned ret = 0;
+    const ResPool & pool(God->pool());
+    for_(it, pool.begin(), pool.end())
+    {
+      if ((it->status().transacts() && !it->status().isBySolver())
+          || it->status().isLocked())
+        ++ret;
+    }
+    return ret;
+  }
+
+private:
+  struct Pass
+  {
+    Pass() : us(0), jobs(0), success(false), problems(0), transaction(0) {}
+
+    string type;
+    unsigned long long us;
+    unsigned jobs;
+    bool success;
+    unsigned problems;
+    unsigned transaction;
+  };
+  vector<Pass> _passes;
+  unsigned _round;		//< of solving and committing
+  unsigned long long _started;
+};
+
 static void show_update_messages(Zypper & zypper, const UpdateNotifications & messages)
 {
   if (messages.empty())
@@ -462,7 +684,6 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
   zypper.out().info(_("Update notifications were received from the following packages:"));
   MIL << "Received " << messages.size() << " update notification(s):" << endl;
 
-  std::ostringstream msg;
   for_(it, messages.begin(), messages.end())
   {
     MIL << "- From " << it->solvable().asString()
@@ -470,12 +691,6 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
     zypper.out().info(
         it->solvable().asString() + " (" +
         Pathname::showRootIf(zypper.globalOpts().root_dir, it->file()) + ")");
-    {
-      msg << str::form(_("Message from package %s:"), it->solvable().name().c_str()) << endl << endl;
-      InputStream istr(Pathname::assertprefix(zypper.globalOpts().root_dir, it->file()));
-      iostr::copy(istr, msg);
-      msg << endl << "-----------------------------------------------------------------------------" << endl;
-    }
   }
 
   PromptOptions popts;
@@ -489,7 +704,20 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
   reply = get_prompt_reply(zypper, PROMPT_YN_INST_REMOVE_CONTINUE, popts);
 
   if (reply == 0)
-    show_text_in_pager(msg.str());
+  {
+    // the notification files are streamed into the pager, not read in advance
+    Pathname root( zypper.globalOpts().root_dir );
+    show_in_pager( [&messages,&root]( std::ostream & msg )
+    {
+      for_(it, messages.begin(), messages.end())
+      {
+        msg << str::form(_("Message from package %s:"), it->solvable().name().c_str()) << '\n' << '\n';
+        InputStream istr(Pathname::assertprefix(root, it->file()));
+        iostr::copy(istr, msg);
+        msg << '\n' << "-----------------------------------------------------------------------------" << '\n';
+      }
+    } );
+  }
 }
 
 
@@ -509,6 +737,13 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
 void solve_and_commit (Zypper & zypper)
 {
   bool need_another_solver_run = true;
+  scoped_ptr<SolverStats> stats;
+  if (zypper.globalOpts().solver_stats)
+    stats.reset(new SolverStats);
+  scoped_ptr<SolutionCache> solution_cache;
+  if (!zypper.config().solver_solutionCache.empty())
+    solution_cache.reset(new SolutionCache(zypper.config().solver_solutionCache));
+  string fingerprint;
   do
   {
     // CALL SOLVER
@@ -517,39 +752,84 @@ void solve_and_commit (Zypper & zypper)
     if (zypper.runtimeData().solve_before_commit)
     {
       MIL << "solving..." << endl;
+      if (stats)
+        stats->nextRound();
+
+      bool solved = false;
+      if (solution_cache)
+      {
+        // the fingerprint covers the resolver's settings
+        set_solver_flags(zypper, false);
+        fingerprint = SolutionCache::fingerprint(God->pool(), solver_request(zypper));
+        string reason;
+        if (!zypper.cOpts().count("debug-solver")
+            && solution_cache->apply(fingerprint, God->pool(), reason))
+        {
+          zypper.out().info(boost::str(format(
+              _("Using the cached solution %s.")) % fingerprint), Out::HIGH);
+          solved = true;
+        }
+        else
+          DBG << "not using the cached solution " << fingerprint << ": " << reason << endl;
+      }
 
-      while (true)
+      // a solution the user had to help with is not for the cache
+      bool first_pass = true;
+      while (!solved)
       {
         bool success;
         if (zypper.command() == ZypperCommand::VERIFY)
+        {
+          if (stats)
+            stats->start("verify");
           success = verify(zypper);
+        }
         else if (zypper.command() == ZypperCommand::DIST_UPGRADE)
         {
           zypper.out().info(_("Computing distribution upgrade..."));
+          if (stats)
+            stats->start("dist-upgrade");
           success = dist_upgrade(zypper);
         }
         else
         {
           zypper.out().info(_("Resolving package dependencies..."));
+          if (stats)
+            stats->start("resolve");
           success = resolve(zypper);
         }
+        if (stats)
+          stats->done(success);
 
         // go on, we've got solution or we don't want a solution (we want testcase)
         if (success || zypper.cOpts().count("debug-solver"))
+        {
+          if (success && first_pass && solution_cache
+              && !zypper.cOpts().count("debug-solver"))
+            solution_cache->store(fingerprint, God->pool());
           break;
+        }
+        first_pass = false;
 
         success = show_problems(zypper);
         if (!success)
         {
+          if (stats)
+            stats->show(zypper);
           zypper.setExitCode(ZYPPER_EXIT_ERR_ZYPP); // bnc #242736
           return;
         }
       }
+
+      if (stats)
+        stats->show(zypper);
     }
 
     if (zypper.cOpts().count("debug-solver"))
     {
       make_solver_test_case(zypper);
+      if (solution_cache && !fingerprint.empty())
+        replay_cached_solution(zypper, *solution_cache, fingerprint);
       return;
     }
 
@@ -557,7 +837,14 @@ void solve_and_commit (Zypper & zypper)
 
     // SHOW SUMMARY
 
-    Summary summary(God->pool());
+    scoped_ptr<Summary> summary_ptr;
+    {
+      Profiler::Span span("summary");
+      summary_ptr.reset(new Summary(God->pool()));
+    }
+    Summary & summary(*summary_ptr);
+    if (zypper.globalOpts().timings)
+      show_summary_timings(zypper, summary);
 
     if (zypper.out().verbosity() == Out::HIGH)
       summary.setViewOption(Summary::SHOW_VERSION);
@@ -719,11 +1006,9 @@ void solve_and_commit (Zypper & zypper)
         }
         case 8: // g - view in pager
         {
-          ostringstream s;
           summary.setForceNoColor(true);
-          summary.dumpTo(s);
+          show_in_pager( [&summary]( std::ostream & s ) { summary.dumpTo(s); } );
           summary.setForceNoColor(false);
-          show_text_in_pager(s.str());
           break;
         }
         default: // n - no
@@ -742,6 +1027,19 @@ void solve_and_commit (Zypper & zypper)
         if (!confirm_licenses(zypper))
           return;
 
+        // forget the overall download progress and stop fetching packages
+        // however the commit ends
+        struct ResetDownloads {
+          ~ResetDownloads() {
+            Zypper::instance()->out().downloads().reset();
+            Zypper::instance()->runtimeData().prefetcher.reset();
+            Zypper::instance()->runtimeData().packageStore.reset();
+          }
+        } reset_downloads __attribute__ ((__unused__));
+
+        // files the commit deletes, for the check for processes using them
+        DeletedFilesScanner::Files removed_files;
+
         try
         {
           RuntimeData & gData = Zypper::instance()->runtimeData();
@@ -750,6 +1048,8 @@ void solve_and_commit (Zypper & zypper)
           // To be used to write overall progress of retrieving packages.
           gData.commit_pkgs_total = summary.packagesToGetAndInstall();
           gData.commit_pkg_current = 0;
+          zypper.out().downloads().expect(
+              summary.packagesToGetAndInstall(), summary.toDownload());
           // To be used to show overall progress of rpm transactions.
           gData.rpm_pkgs_total = God->resolver()->getTransaction().actionSize();
           gData.rpm_pkg_current = 0;
@@ -760,7 +1060,37 @@ void solve_and_commit (Zypper & zypper)
             s << " " << _("(dry run)") << endl;
           zypper.out().info(s.str(), Out::HIGH);
 
-          ZYppCommitResult result = God->commit(get_commit_policy(zypper));
+          ZYppCommitPolicy policy(get_commit_policy(zypper));
+          if (!policy.dryRun() && (summary.packagesToRemove() ||
+                                   summary.packagesToUpgrade() ||
+                                   summary.packagesToDowngrade()))
+            removed_files = DeletedFilesScanner::filesRemovedBy(
+                God->pool(), zypper.globalOpts().root_dir);
+
+          time_t commit_start = ::time(0);
+          Profiler::Span commit_span("commit");
+          if (!policy.dryRun() && !zypper.config().cache_packagesStore.empty())
+          {
+            // before counting cache hits, the store ones are hits, too
+            gData.packageStore.reset(
+                new PackageStore(zypper.config().cache_packagesStore));
+            gData.packageStore->provide(God->pool());
+          }
+          if (!policy.dryRun())
+            PackageCache(zypper.globalOpts().rm_options.repoPackagesCachePath)
+              .commitStarts(God->pool());
+          if (download_pipelined(zypper) && !policy.dryRun())
+          {
+            // same order as the commit will use
+            sat::Transaction trans(God->resolver()->getTransaction());
+            trans.order();
+            gData.prefetcher.reset(new PackagePrefetcher(
+                zypper.config().commit_downloadJobs,
+                zypper.config().commit_downloadBudget));
+            gData.prefetcher->start(trans);
+          }
+
+          ZYppCommitResult result = God->commit(policy);
 
           MIL << endl << "DONE" << endl;
 
@@ -773,6 +1103,22 @@ void solve_and_commit (Zypper & zypper)
           zypper.out().info(s.str(), Out::HIGH);
 
           show_update_messages(zypper, result.updateMessages());
+
+          if (gData.packageStore)
+          {
+            gData.packageStore->addRemaining();
+            if (gData.packageStore->provided())
+              zypper.out().info(boost::str(format(
+                  _PL("%u package was taken from the package store.",
+                      "%u packages were taken from the package store.",
+                      gData.packageStore->provided()))
+                  % gData.packageStore->provided()), Out::HIGH);
+          }
+
+          // what this commit used stays, the packages to be installed
+          // after --download-only in particular
+          if (!policy.dryRun())
+            limit_package_cache(zypper, Out::HIGH, commit_start);
         }
         catch ( const media::MediaException & e )
         {
@@ -876,10 +1222,8 @@ void solve_and_commit (Zypper & zypper)
         }
 
         // check for running services (fate #300763)
-        if (summary.packagesToRemove() ||
-            summary.packagesToUpgrade() ||
-            summary.packagesToDowngrade())
-          notify_processes_using_deleted_files(zypper);
+        if (!removed_files.empty())
+          notify_processes_using_deleted_files(zypper, removed_files);
       }
     }
     // noting to do
@@ -9,8 +9,10 @@
 
 #include <zypp/Patch.h>
 
+#include "Profiler.h"
 #include "SolverRequester.h"
 #include "Table.h"
+#include "UpdateCandidates.h"
 #include "update.h"
 #include "main.h"
 
@@ -43,28 +45,29 @@ find_updates( const ResKindSet & kinds, Candidates & candidates );
 // update summary must correspond to list-updates and patch-check
 // ----------------------------------------------------------------------------
 
+const UpdateCandidates::Patches & needed_patches(Zypper & zypper)
+{
+  const UpdateCandidates::Patches & patches(UpdateCandidates::instance().patches());
+  zypper.out().info(str::form(
+      // translators: %u are numbers of patches, %.1f is milliseconds
+      _("%u of %u patches needed (indexed in %.1f ms)."),
+      unsigned(patches.needed.size()), patches.total, patches.time_us / 1000.0),
+      Out::HIGH);
+  return patches;
+}
+
+// ----------------------------------------------------------------------------
+
 void patch_check ()
 {
   Out & out = Zypper::instance()->out();
   RuntimeData & gData = Zypper::instance()->runtimeData();
   DBG << "patch check" << endl;
-  gData.patches_count = gData.security_patches_count = 0;
-
-  ResPool::byKind_iterator
-    it = God->pool().byKindBegin(ResKind::patch),
-    e = God->pool().byKindEnd(ResKind::patch);
-  for (; it != e; ++it )
-  {
-    ResObject::constPtr res = it->resolvable();
-    Patch::constPtr patch = asKind<Patch>(res);
+  Profiler::Span span("patch check");
 
-    if (it->isRelevant() && !it->isSatisfied())
-    {
-      gData.patches_count++;
-      if (patch->categoryEnum() == Patch::CAT_SECURITY)
-        gData.security_patches_count++;
-    }
-  }
+  UpdateCandidates::PatchCounts counts( needed_patches(*Zypper::instance()).counts() );
+  gData.patches_count = counts.needed;
+  gData.security_patches_count = counts.security;
 
   ostringstream s;
   // translators: %d is the number of needed patches
@@ -99,28 +102,17 @@ inline const char *const patchStatusAsString( const PoolItem & pi_r )
 static bool xml_list_patches (Zypper & zypper)
 {
   const zypp::ResPool& pool = God->pool();
-
-  unsigned int patchcount=0;
-  bool pkg_mgr_available = false;
-  Patch::constPtr patch;
-
-  ResPool::byKind_iterator
-    it = pool.byKindBegin(ResKind::patch),
-    e  = pool.byKindEnd(ResKind::patch);
+  const UpdateCandidates::Patches & patches(needed_patches(zypper));
 
   // check whether there are packages affecting the update stack
-  for (; it != e; ++it)
-  {
-    patch = asKind<Patch>(it->resolvable());
-    if (it->isRelevant() && !it->isSatisfied() && patch->restartSuggested())
-    {
-      pkg_mgr_available = true;
-      break;
-    }
-  }
-
-  it = pool.byKindBegin(ResKind::patch);
-  for (; it != e; ++it, ++patchcount)
+  bool pkg_mgr_available = !patches.pkgManager.empty();
+
+  // only the needed ones unless --all
+  vector<PoolItem> allpatches;
+  if (zypper.cOpts().count("all"))
+    allpatches.assign(pool.byKindBegin(ResKind::patch), pool.byKindEnd(ResKind::patch));
+  const vector<PoolItem> & shown(zypper.cOpts().count("all") ? allpatches : patches.needed);
+  for_(it, shown.begin(), shown.end())
   {
     if (zypper.cOpts().count("all") || it->isBroken())
     {
@@ -164,7 +156,7 @@ static bool xml_list_patches (Zypper & zypper)
   }
 
   //! \todo change this from appletinfo to something general, define in xmlout.rnc
-  if (patchcount == 0)
+  if (patches.total == 0)
     cout << "<appletinfo status=\"no-update-repositories\"/>" << endl;
 
   return pkg_mgr_available;
@@ -263,10 +255,12 @@ static bool list_patch_updates(Zypper & zypper)
   tbl << th;
   pm_tbl << th;
   const zypp::ResPool& pool = God->pool();
-  ResPool::byKind_iterator
-    it = pool.byKindBegin(ResKind::patch),
-    e  = pool.byKindEnd(ResKind::patch);
-  for (; it != e; ++it )
+  // only the needed ones unless --all
+  vector<PoolItem> allpatches;
+  if (all)
+    allpatches.assign(pool.byKindBegin(ResKind::patch), pool.byKindEnd(ResKind::patch));
+  const vector<PoolItem> & shown(all ? allpatches : needed_patches(zypper).needed);
+  for_(it, shown.begin(), shown.end())
   {
     ResObject::constPtr res = it->resolvable();
 
@@ -342,7 +336,6 @@ static bool list_patch_updates(Zypper & zypper)
 static void
 find_updates( const ResKind & kind, Candidates & candidates )
 {
-  const zypp::ResPool& pool = God->pool();
   DBG << "Looking for update candidates of kind " << kind << endl;
 
   // package updates
@@ -373,20 +366,13 @@ find_updates( const ResKind & kind, Candidates & candidates )
 
   // get --all available updates, no matter if they are installable or break
   // some current policy
-  for_(it, pool.proxy().byKindBegin(kind), pool.proxy().byKindEnd(kind))
+  const UpdateCandidates::Candidates & available(
+      UpdateCandidates::instance().candidates(kind));
+  for_(it, available.begin(), available.end())
   {
-    if (!(*it)->hasInstalledObj())
-      continue;
-
-    PoolItem candidate = (*it)->highestAvailableVersionObj(); // bnc #557557
-    if (!candidate)
-      continue;
-    if (compareByNVRA((*it)->installedObj().resolvable(), candidate.resolvable()) >= 0)
-      continue;
-
-    DBG << "selectable: " << **it << endl;
-    DBG << "candidate: " << candidate << endl;
-    candidates.insert (candidate);
+    DBG << "selectable: " << *it->selectable << endl;
+    DBG << "candidate: " << it->candidate << endl;
+    candidates.insert(it->candidate);
   }
 }
 
@@ -423,10 +409,9 @@ string i18n_kind_updates(const ResKind & kind)
 
 // ----------------------------------------------------------------------------
 
-// FIXME rewrite this function so that first the list of updates is collected and later correctly presented (bnc #523573)
-
 void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
 {
+  Profiler::Span span("list updates");
   if (zypper.out().type() == Out::TYPE_XML)
   {
     cout << "<update-status version=\"0.6\">" << endl;
@@ -476,6 +461,11 @@ void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
   if (affects_pkgmgr)
     return;
 
+  // collect the updates of all kinds first, then present them (bnc #523573)
+  map<ResKind, Candidates> collected;
+  for (it = localkinds.begin(); it != localkinds.end(); ++it)
+    find_updates( *it, collected[*it] );
+
   // normal output here
   for (it = localkinds.begin(); it != localkinds.end(); ++it)
   {
@@ -512,10 +502,9 @@ void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
 
     ResPoolProxy uipool( ResPool::instance().proxy() );
 
-    Candidates candidates;
-    find_updates( *it, candidates );
+    const Candidates & candidates( collected[*it] );
 
-    Candidates::iterator cb = candidates.begin (), ce = candidates.end (), ci;
+    Candidates::const_iterator cb = candidates.begin (), ce = candidates.end (), ci;
     for (ci = cb; ci != ce; ++ci) {
       ResObject::constPtr res = ci->resolvable();
       TableRow tr (cols);
@@ -3,6 +3,13 @@
 #include "Zypper.h"
 
 #include "utils/misc.h"
+#include "UpdateCandidates.h"
+
+/**
+ * The needed patches (see \ref UpdateCandidates::patches), reporting
+ * how long indexing them took in verbose mode.
+ */
+const UpdateCandidates::Patches & needed_patches(Zypper & zypper);
 
 /**
  * Are there applicable patches?
@@ -0,0 +1,151 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+#include <cctype>
+#include <fstream>
+#include <stdlib.h>
+
+#include <zypp/base/Easy.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/Pathname.h>
+#include <zypp/PathInfo.h>
+
+#include "main.h"
+#include "utils/Augeas.h"
+#include "utils/ConfigReader.h"
+
+using namespace zypp;
+using namespace std;
+
+// ---------------------------------------------------------------------------
+
+/** Whether \a str is a section title ([title]), as accepted by zypper.aug. */
+static bool is_section_title(const string & str)
+{
+  if (str.size() < 3 || str[0] != '[' || str[str.size() - 1] != ']')
+    return false;
+  return str.find_first_of("] \t/", 1) == str.size() - 1;
+}
+
+/** Whether \a str is an option name, as accepted by zypper.aug. */
+static bool is_keyword(const string & str)
+{
+  if (str.size() < 2 || !::isalpha((unsigned char)str[0])
+      || !::isalnum((unsigned char)str[str.size() - 1]))
+    return false;
+  for_(c, str.begin(), str.end())
+    if (!::isalnum((unsigned char)*c) && *c != '.' && *c != '_')
+      return false;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+
+ConfigReader::ConfigReader(const string & file)
+{
+  MIL << "Going to read zypper config..." << endl;
+
+  // the same files as Augeas reads
+  vector<Pathname> files;
+  Pathname filepath(file);
+  if (!file.empty() && PathInfo(filepath).isExist())
+  {
+    if (filepath.relative())
+    {
+      const char * env = ::getenv("PWD");
+      filepath = Pathname(env ? env : ".") / filepath;
+    }
+    files.push_back(filepath);
+  }
+  else
+  {
+    const char * env = ::getenv("HOME");
+    if (env && *env)
+      files.push_back(Pathname(env) / ".zypper.conf");
+    else
+      WAR << "Cannot figure out user's home directory. Skipping user's config." << endl;
+    files.push_back("/etc/zypp/zypper.conf");
+  }
+
+  for_(it, files.begin(), files.end())
+  {
+    ifstream in(it->c_str());
+    if (!in)
+    {
+      MIL << "not read: " << *it << endl;
+      continue;
+    }
+    _files.push_back(Options());
+    if (!parse(in, _files.back()))
+    {
+      MIL << "Syntax not handled natively in " << *it << ", using Augeas" << endl;
+      _files.clear();
+      _augeas.reset(new Augeas(file));
+      return;
+    }
+    MIL << "read " << *it << ": " << _files.back().size() << " options" << endl;
+  }
+
+  if (_files.empty())
+    ZYPP_THROW(Exception(
+        _("No configuration file exists or could be parsed.")));
+}
+
+ConfigReader::~ConfigReader()
+{}
+
+// ---------------------------------------------------------------------------
+
+string ConfigReader::getOption(const string & option) const
+{
+  if (_augeas)
+    return _augeas->getOption(option);
+
+  for_(it, _files.begin(), _files.end())
+  {
+    Options::const_iterator opt = it->find(option);
+    if (opt != it->end())
+    {
+      DBG << "Got " << option << " = " << opt->second << endl;
+      return opt->second;
+    }
+  }
+  return string();
+}
+
+// ---------------------------------------------------------------------------
+
+bool ConfigReader::parse(istream & in_r, Options & options_r)
+{
+  string section;
+  string line;
+  while (getline(in_r, line))
+  {
+    line = str::trim(line);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    if (line[0] == '[')
+    {
+      if (!is_section_title(line))
+        return false;
+      section = line.substr(1, line.size() - 2);
+      continue;
+    }
+
+    string::size_type eq = line.find('=');
+    if (section.empty() || eq == string::npos)
+      return false;
+    string key(str::trim(line.substr(0, eq)));
+    string value(str::trim(line.substr(eq + 1)));
+    if (!is_keyword(key) || value.empty())
+      return false;
+    if (!options_r.insert(make_pair(section + "/" + key, value)).second)
+      return false;
+  }
+  return true;
+}
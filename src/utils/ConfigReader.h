@@ -0,0 +1,64 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UTIL_CONFIGREADER_H_
+#define ZYPPER_UTIL_CONFIGREADER_H_
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <zypp/base/NonCopyable.h>
+#include <zypp/base/PtrTypes.h>
+
+class Augeas;
+
+/**
+ * Reads the options of the zypper.conf files.
+ *
+ * Which files are read, and which one wins, is the same as with \ref Augeas:
+ * the given file if it exists, otherwise ~/.zypper.conf over
+ * /etc/zypp/zypper.conf.
+ *
+ * The files are parsed natively, which takes a fraction of the time needed
+ * to initialize Augeas and load its lens. Only if a file contains something
+ * the native parser does not handle, all of them are read using Augeas,
+ * which also reports the errors.
+ */
+class ConfigReader : private zypp::base::NonCopyable
+{
+public:
+  /** Options of a file, by "section/option". */
+  typedef std::map<std::string, std::string> Options;
+
+  ConfigReader( const std::string & file = "" );
+  ~ConfigReader();
+
+  /** The value of \a option ("section/option"), empty if not set. */
+  std::string getOption( const std::string & option ) const;
+
+  /** Whether the files had to be read using Augeas. */
+  bool usingAugeas() const
+  { return _augeas.get(); }
+
+  /**
+   * Parse the zypper.conf syntax: [section] titles, option = value lines,
+   * comments and empty lines.
+   *
+   * \return false if \a in_r contains anything else, or an option twice
+   *    (which Augeas does not consider set).
+   */
+  static bool parse( std::istream & in_r, Options & options_r );
+
+private:
+  /** The options of the files read, the winning one first. */
+  std::vector<Options> _files;
+  zypp::shared_ptr<Augeas> _augeas;
+};
+
+#endif /* ZYPPER_UTIL_CONFIGREADER_H_ */
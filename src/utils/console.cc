@@ -9,6 +9,9 @@
  * Miscellaneous console utilities.
  */
 #include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
 
 #include <string>
 #include <fstream>
@@ -51,26 +54,81 @@ string readline_getline()
 
 // ----------------------------------------------------------------------------
 
+namespace
+{
+  /** Set by \ref sigwinch_handler, tells \ref get_screen_width to re-read the
+   * terminal geometry. Initially set, so the first call computes it. */
+  volatile sig_atomic_t _screen_size_changed = 1;
+
+  struct sigaction _old_sigwinch_action;
+
+  void sigwinch_handler( int sig_r )
+  {
+    _screen_size_changed = 1;
+    // chain to a handler installed before us (e.g. readline's)
+    if ( _old_sigwinch_action.sa_handler != SIG_DFL
+         && _old_sigwinch_action.sa_handler != SIG_IGN
+         && _old_sigwinch_action.sa_handler != sigwinch_handler )
+      _old_sigwinch_action.sa_handler( sig_r );
+  }
+
+  void install_sigwinch_handler()
+  {
+    struct sigaction action;
+    ::memset( &action, 0, sizeof(action) );
+    action.sa_handler = sigwinch_handler;
+    ::sigemptyset( &action.sa_mask );
+    action.sa_flags = SA_RESTART;
+    ::sigaction( SIGWINCH, &action, &_old_sigwinch_action );
+  }
+
+  unsigned read_screen_width()
+  {
+    int width = 0;
+
+    const char *cols_env = getenv("COLUMNS");
+    if (cols_env)
+      width  = ::atoi (cols_env);
+    else
+    {
+      struct winsize wns;
+      if ( ::ioctl( STDOUT_FILENO, TIOCGWINSZ, &wns ) == 0 )
+        width = wns.ws_col;
+      else
+      {
+        ::rl_initialize();
+        //::rl_reset_screen_size();
+        ::rl_get_screen_size (NULL, &width);
+      }
+    }
+
+    // safe default
+    if (width <= 0)
+      width = 80;
+
+    return width;
+  }
+} // namespace
+
 unsigned get_screen_width()
 {
   if (!::isatty(STDOUT_FILENO))
     return -1; // no clipping
 
-  int width = 80;
+  static bool handler_installed = false;
+  static unsigned width = 80;
 
-  const char *cols_env = getenv("COLUMNS");
-  if (cols_env)
-    width  = ::atoi (cols_env);
-  else
+  if ( ! handler_installed )
   {
-    ::rl_initialize();
-    //::rl_reset_screen_size();
-    ::rl_get_screen_size (NULL, &width);
+    install_sigwinch_handler();
+    handler_installed = true;
   }
 
-  // safe default
-  if (!width)
-    width = 80;
+  if ( _screen_size_changed )
+  {
+    _screen_size_changed = 0;
+    width = read_screen_width();
+  }
 
   return width;
 }
@@ -19,6 +19,9 @@ std::string readline_getline();
  * Reads COLUMNS environment variable or gets the screen width from readline,
  * in that order. Falls back to 80 if all that fails.
  *
+ * The width is computed once and cached. A SIGWINCH handler installed on
+ * the first call invalidates the cached value when the terminal is resized.
+ *
  * \NOTE In case stdout is not connected to a terminal max. unsigned
  * is returned. This should prevent clipping when output is redirected.
  */
@@ -31,6 +31,8 @@ boost::tribool get_boolean_option(
 class Args {
 public:
   Args (const std::string& s);
+  Args (const std::vector<std::string>& args)
+    : _args (args), _argv (NULL) {}
 
   ~Args () {
     clear_argv ();
@@ -7,7 +7,17 @@
 
 #include <sstream>
 #include <iostream>
+#include <fstream>
+#include <map>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <unistd.h>          // for getcwd()
+#include <time.h>            // for clock_gettime()
+#include <sys/ioctl.h>       // for reflinks
+#include <sys/wait.h>
 
 #include <zypp/base/Logger.h>
 #include <zypp/base/String.h>
@@ -25,6 +35,7 @@
 #include "main.h"
 #include "Zypper.h"
 #include "Table.h"             // for process list in suggest_restart_services
+#include "DeletedFilesScanner.h"
 
 #include "utils/misc.h"
 
@@ -276,46 +287,419 @@ bool looks_like_rpm_file(const string & s)
 
 // ----------------------------------------------------------------------------
 
-Pathname cache_rpm(const string & rpm_uri_str, const string & cache_dir)
+namespace
 {
-  Url rpmurl = make_url(rpm_uri_str);
-  Pathname rpmpath(rpmurl.getPathName());
-  rpmurl.setPathName(rpmpath.dirname().asString()); // directory
-  rpmpath = rpmpath.basename(); // rpm file name
+  /** An RPM file to get into the cache. */
+  struct RpmToCache
+  {
+    RpmToCache() : done(false), copyFailed(false), nameClash(false) {}
+
+    Pathname onMedia;	//< path on the attached media
+    Pathname target;	//< path in the cache
+    bool done;
+    bool copyFailed;	//< retrieved, but not put into the cache
+    bool nameClash;	//< another file has the same target
+    string error;
+  };
 
-  try
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+  /**
+   * Put \a from_r to \a to_r the cheapest way possible: rename it if we may
+   * \a move_r it, otherwise hardlink, reflink, and only then copy it.
+   *
+   * A file given by the user is hardlinked only if nobody but root can
+   * change it: the cached file is installed after its header was read.
+   */
+  int place_file(const Pathname & from_r, const Pathname & to_r, bool move_r)
   {
-    media::MediaManager mm;
-    media::MediaAccessId mid = mm.open(rpmurl);
-    mm.attach(mid);
+    PathInfo from(from_r);
+    PathInfo to(to_r);
+    bool linkable = move_r
+        || (from.owner() == 0 && !(from.st_mode() & (S_IWGRP | S_IWOTH)));
+    if (linkable && to.isExist() && to.ino() == from.ino() && to.dev() == from.dev())
+      return 0;	// already there
+
+    if (move_r && ::rename(from_r.c_str(), to_r.c_str()) == 0)
+      return 0;
+
+    filesystem::unlink(to_r);
+    if (linkable && ::link(from_r.c_str(), to_r.c_str()) == 0)
+      return 0;
+
+    int src = ::open(from_r.c_str(), O_RDONLY);
+    if (src >= 0)
+    {
+      int dst = ::open(to_r.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+      int ret = (dst >= 0 ? ::ioctl(dst, FICLONE, src) : -1);
+      if (dst >= 0)
+        ::close(dst);
+      ::close(src);
+      if (ret == 0)
+        return 0;
+      filesystem::unlink(to_r);
+    }
 
-    mm.provideFile(mid, rpmpath.basename());
-    Pathname localrpmpath = mm.localPath(mid, rpmpath.basename());
-    Pathname cachedrpmpath = cache_dir;
-    filesystem::assert_dir(cachedrpmpath);
-    bool error =
-      filesystem::copy(localrpmpath, cachedrpmpath / localrpmpath.basename());
+    return filesystem::copy(from_r, to_r);
+  }
 
-    mm.release(mid);
-    mm.close(mid);
+  /**
+   * Attach \a url_r once and get all \a files_r from it. Files of downloading
+   * media are moved out of the attach point, local ones are linked.
+   */
+  void provide_rpms(const Url & url_r, const vector<RpmToCache*> & files_r)
+  {
+    bool move = url_r.schemeIsDownloading();
+    try
+    {
+      media::MediaManager mm;
+      media::MediaAccessId mid = mm.open(url_r);
+      mm.attach(mid);
+
+      for_(it, files_r.begin(), files_r.end())
+      {
+        RpmToCache & rpm(**it);
+        try
+        {
+          mm.provideFile(mid, rpm.onMedia);
+          if (place_file(mm.localPath(mid, rpm.onMedia), rpm.target, move) == 0)
+            rpm.done = true;
+          else
+            rpm.copyFailed = true;
+        }
+        catch (const Exception & e)
+        {
+          ZYPP_CAUGHT(e);
+          rpm.error = e.asUserHistory();
+        }
+      }
 
-    if (error)
+      mm.release(mid);
+      mm.close(mid);
+    }
+    catch (const Exception & e)
     {
-      Zypper::instance()->out().error(
-        _("Problem copying the specified RPM file to the cache directory."),
-        _("Perhaps you are running out of disk space."));
-      return Pathname();
+      ZYPP_CAUGHT(e);
+      for_(it, files_r.begin(), files_r.end())
+        if (!(*it)->done && !(*it)->copyFailed && (*it)->error.empty())
+          (*it)->error = e.asUserHistory();
     }
-    return cachedrpmpath / localrpmpath.basename();
   }
-  catch (const Exception & e)
+
+  /**
+   * Runs in a worker process: provide_rpms() and write the outcome to
+   * \a result_r, one NUL terminated record per file: "done", "copy", or the
+   * error message.
+   */
+  int provide_rpms_worker(const Url & url_r, const vector<RpmToCache*> & files_r,
+                          const Pathname & result_r)
   {
-    Zypper::instance()->out().error(e,
-        _("Problem retrieving the specified RPM file") + string(":"),
+    // nobody to ask for credentials, the parent retries what failed
+    Zypper::instance()->globalOptsNoConst().non_interactive = true;
+    ::signal(SIGCHLD, SIG_DFL);
+    int devnull = ::open("/dev/null", O_RDWR);
+    if (devnull >= 0)
+    {
+      ::dup2(devnull, 0);
+      ::dup2(devnull, 1);
+      ::dup2(devnull, 2);
+    }
+
+    provide_rpms(url_r, files_r);
+
+    ofstream result(result_r.c_str());
+    for_(it, files_r.begin(), files_r.end())
+    {
+      if ((*it)->done)
+        result << "done";
+      else if ((*it)->copyFailed)
+        result << "copy";
+      else
+        result << (*it)->error;
+      result << '\0';
+    }
+    return result.good() ? 0 : 1;
+  }
+
+  /** Read the outcome written by provide_rpms_worker(). */
+  void read_worker_result(const Pathname & result_r, const vector<RpmToCache*> & files_r)
+  {
+    ifstream result(result_r.c_str());
+    string record;
+    for_(it, files_r.begin(), files_r.end())
+    {
+      if (!getline(result, record, '\0'))
+      {
+        (*it)->error = _("The download process failed.");
+        continue;
+      }
+      if (record == "done")
+        (*it)->done = true;
+      else if (record == "copy")
+        (*it)->copyFailed = true;
+      else
+        (*it)->error = record;
+    }
+    filesystem::unlink(result_r);
+  }
+
+  /** Write end of the pipe through which \ref sigchld_handler wakes
+   * \ref ChildWaiter. */
+  int _sigchld_pipe = -1;
+
+  void sigchld_handler(int)
+  {
+    int saved_errno = errno;
+    if (_sigchld_pipe >= 0 && ::write(_sigchld_pipe, "", 1) < 0)
+    {}  // full, a wakeup is pending anyway
+    errno = saved_errno;
+  }
+
+  /**
+   * Waits for one of our workers to exit, sleeping until a SIGCHLD arrives
+   * instead of polling. Children of zypper which aren't ours are left alone.
+   */
+  class ChildWaiter
+  {
+  public:
+    ChildWaiter()
+    {
+      if (::pipe2(_pipe, O_CLOEXEC | O_NONBLOCK) != 0)
+      {
+        WAR << "pipe: " << ::strerror(errno) << endl;
+        _pipe[0] = _pipe[1] = -1;
+        return;
+      }
+      _sigchld_pipe = _pipe[1];
+      struct sigaction action;
+      ::memset(&action, 0, sizeof(action));
+      action.sa_handler = sigchld_handler;
+      ::sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+      ::sigaction(SIGCHLD, &action, &_old_action);
+    }
+
+    ~ChildWaiter()
+    {
+      if (_pipe[0] < 0)
+        return;
+      ::sigaction(SIGCHLD, &_old_action, NULL);
+      _sigchld_pipe = -1;
+      ::close(_pipe[0]);
+      ::close(_pipe[1]);
+    }
+
+    /** Reap and return the first of \a running_r to exit. */
+    pid_t wait(const map<pid_t, unsigned> & running_r)
+    {
+      for (;;)
+      {
+        for_(it, running_r.begin(), running_r.end())
+        {
+          int status;
+          if (::waitpid(it->first, &status, WNOHANG) == it->first)
+            return it->first;
+        }
+
+        if (_pipe[0] < 0)
+        {
+          // no wakeups, block on the oldest
+          int status;
+          pid_t pid = running_r.begin()->first;
+          while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+          {}
+          return pid;
+        }
+
+        // a child exiting after the scan above has written to the pipe
+        struct pollfd pfd;
+        pfd.fd = _pipe[0];
+        pfd.events = POLLIN;
+        ::poll(&pfd, 1, -1);
+        char buf[64];
+        while (::read(_pipe[0], buf, sizeof(buf)) > 0)
+        {}
+      }
+    }
+
+  private:
+    int _pipe[2];
+    struct sigaction _old_action;
+  };
+} // namespace
+
+vector<Pathname> cache_rpms(const vector<string> & rpm_uris, const string & cache_dir)
+{
+  Zypper & zypper(*Zypper::instance());
+  filesystem::assert_dir(cache_dir);
+
+  // one media for each directory of local media, and for each host of
+  // downloading ones; the latter get their files concurrently
+  vector<RpmToCache> rpms(rpm_uris.size());
+  typedef map<string, pair<Url, vector<RpmToCache*> > > MediaFiles;
+  MediaFiles local;
+  MediaFiles remote;
+  map<Pathname, unsigned> targets;
+  vector<int> same_as(rpm_uris.size(), -1);	// the same URI given before
+  for (unsigned i = 0; i < rpm_uris.size(); ++i)
+  {
+    Url url = make_url(rpm_uris[i]);
+    Pathname path(url.getPathName());
+    rpms[i].target = Pathname(cache_dir) / path.basename();
+
+    // files of the same name would overwrite each other in the cache
+    map<Pathname, unsigned>::const_iterator known(targets.find(rpms[i].target));
+    if (known != targets.end())
+    {
+      if (rpm_uris[known->second] == rpm_uris[i])
+        same_as[i] = known->second;
+      else
+        rpms[i].nameClash = true;
+      continue;
+    }
+    targets[rpms[i].target] = i;
+
+    if (url.schemeIsDownloading())
+    {
+      rpms[i].onMedia = path;
+      url.setPathName("/");
+      MediaFiles::mapped_type & media(remote[url.asCompleteString()]);
+      media.first = url;
+      media.second.push_back(&rpms[i]);
+    }
+    else
+    {
+      rpms[i].onMedia = path.basename();
+      url.setPathName(path.dirname().asString());
+      MediaFiles::mapped_type & media(local[url.asCompleteString()]);
+      media.first = url;
+      media.second.push_back(&rpms[i]);
+    }
+  }
+
+  for_(it, local.begin(), local.end())
+    provide_rpms(it->second.first, it->second.second);
+
+  // spread each host's files over up to 'jobs' workers, each with its own
+  // attached media
+  unsigned jobs = zypper.config().commit_downloadJobs;
+  if (!jobs)
+    jobs = 1;
+  vector<pair<Url, vector<RpmToCache*> > > chunks;
+  for_(it, remote.begin(), remote.end())
+  {
+    const vector<RpmToCache*> & files(it->second.second);
+    unsigned n = std::min<unsigned>(jobs, files.size());
+    unsigned first = chunks.size();
+    chunks.resize(first + n, make_pair(it->second.first, vector<RpmToCache*>()));
+    for (unsigned i = 0; i < files.size(); ++i)
+      chunks[first + i % n].second.push_back(files[i]);
+  }
+
+  // nothing to overlap: fetch here, showing the progress and asking for
+  // credentials as usual
+  if (jobs == 1 || chunks.size() < 2)
+  {
+    for_(it, chunks.begin(), chunks.end())
+      provide_rpms(it->first, it->second);
+    chunks.clear();
+  }
+
+  Pathname resultdir(zypper.runtimeData().tmpdir.path());
+  map<pid_t, unsigned> running;
+  ChildWaiter waiter;
+  for (unsigned next = 0; next < chunks.size() || !running.empty(); )
+  {
+    while (next < chunks.size() && running.size() < jobs)
+    {
+      const Url & url(chunks[next].first);
+      const vector<RpmToCache*> & files(chunks[next].second);
+
+      // no buffered output must be written twice
+      cout.flush();
+      cerr.flush();
+
+      pid_t pid = ::fork();
+      if (pid == 0)
+        ::_exit(provide_rpms_worker(url, files,
+            resultdir / (str::numstring(::getpid()) + ".rpms")));
+      if (pid < 0)
+      {
+        ERR << "fork: " << ::strerror(errno) << endl;
+        provide_rpms(url, files);
+      }
+      else
+      {
+        DBG << "retrieving " << files.size() << " files from " << url << " [" << pid << "]" << endl;
+        running[pid] = next;
+      }
+      ++next;
+    }
+
+    if (running.empty())
+      continue;
+    // wait for any of ours, the others are none of our business
+    pid_t pid = waiter.wait(running);
+    read_worker_result(resultdir / (str::numstring(pid) + ".rpms"),
+                       chunks[running[pid]].second);
+    running.erase(pid);
+  }
+
+  // the workers can't prompt; retry what they failed to get here, where
+  // the user can give credentials
+  if (!zypper.globalOpts().non_interactive)
+  {
+    for_(it, chunks.begin(), chunks.end())
+    {
+      vector<RpmToCache*> failed;
+      for_(file, it->second.begin(), it->second.end())
+        if (!(*file)->done && !(*file)->copyFailed)
+          failed.push_back(*file);
+      if (failed.empty())
+        continue;
+      for_(file, failed.begin(), failed.end())
+        (*file)->error.clear();
+      provide_rpms(it->first, failed);
+    }
+  }
+
+  vector<Pathname> ret;
+  ret.reserve(rpms.size());
+  for (unsigned i = 0; i < rpms.size(); ++i)
+  {
+    if (same_as[i] >= 0)
+    {
+      ret.push_back(ret[same_as[i]]);
+      continue;
+    }
+    if (rpms[i].done)
+    {
+      ret.push_back(rpms[i].target);
+      continue;
+    }
+    if (rpms[i].nameClash)
+      zypper.out().error(str::form(
+        _("Another RPM file named '%s' was specified, skipping '%s'."),
+          rpms[i].target.basename().c_str(), rpm_uris[i].c_str()),
+        _("Rename one of the files."));
+    else if (rpms[i].copyFailed)
+      zypper.out().error(
+        _("Problem copying the specified RPM file to the cache directory."),
+        _("Perhaps you are running out of disk space."));
+    else
+      zypper.out().error(
+        _("Problem retrieving the specified RPM file") + string(":") + "\n" + rpms[i].error,
         _("Please check whether the file is accessible."));
+    ret.push_back(Pathname());
   }
+  return ret;
+}
 
-  return Pathname();
+Pathname cache_rpm(const string & rpm_uri_str, const string & cache_dir)
+{
+  return cache_rpms(vector<string>(1, rpm_uri_str), cache_dir).front();
 }
 
 string xml_encode(const string & text)
@@ -323,6 +707,43 @@ string xml_encode(const string & text)
   return zypp::xml::escape(text);
 }
 
+string json_encode(const string & text)
+{
+  string ret;
+  ret.reserve(text.size());
+  for_(it, text.begin(), text.end())
+  {
+    switch (*it)
+    {
+      case '"':  ret += "\\\""; break;
+      case '\\': ret += "\\\\"; break;
+      case '\n': ret += "\\n";  break;
+      case '\r': ret += "\\r";  break;
+      case '\t': ret += "\\t";  break;
+      default:
+        if ((unsigned char)*it < 0x20)
+          ret += str::form("\\u%04x", (unsigned)(unsigned char)*it);
+        else
+          ret += *it;
+    }
+  }
+  return ret;
+}
+
+unsigned long long monotonic_ms()
+{
+  struct timespec ts;
+  ::clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+unsigned long long monotonic_us()
+{
+  struct timespec ts;
+  ::clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 std::string & indent(std::string & text, int columns)
 {
   string indent(columns, ' '); indent.insert(0, 1, '\n');
@@ -390,19 +811,26 @@ string asXML(const Pattern & p, bool is_installed)
 
 // ----------------------------------------------------------------------------
 
-void list_processes_using_deleted_files(Zypper & zypper)
+void list_processes_using_deleted_files(Zypper & zypper, bool parallel)
 {
   zypper.out().info(
       _("Checking for running processes using deleted libraries..."), Out::HIGH);
-  zypp::CheckAccessDeleted checker(false); // wait for explicit call to check()
-  try
-  {
-    checker.check();
-  }
-  catch(const zypp::Exception & e)
+  DeletedFilesScanner::Result procs;
+  if (parallel)
+    procs = DeletedFilesScanner().scan();
+  else
   {
-    zypper.out().error(e, _("Check failed:"));
-    return;
+    zypp::CheckAccessDeleted checker(false); // wait for explicit call to check()
+    try
+    {
+      checker.check();
+    }
+    catch(const zypp::Exception & e)
+    {
+      zypper.out().error(e, _("Check failed:"));
+      return;
+    }
+    procs.assign(checker.begin(), checker.end());
   }
 
   Table t;
@@ -424,7 +852,7 @@ void list_processes_using_deleted_files(Zypper & zypper)
   th << _("Files");
   t << th;
 
-  for_( it, checker.begin(), checker.end() )
+  for_( it, procs.begin(), procs.end() )
   {
     TableRow tr;
     vector<string>::const_iterator fit = it->files.begin();
@@ -495,13 +923,13 @@ DownloadMode get_download_option(Zypper & zypper, bool quiet)
     mode = DownloadInAdvance;
   else if (download == "in-heaps")
     mode = DownloadInHeaps;
-  else if (download == "as-needed")
-    mode = DownloadAsNeeded;
+  else if (download == "as-needed" || download == "pipelined")
+    mode = DownloadAsNeeded;	// pipelined: as-needed fed by PackagePrefetcher
   else if (!download.empty())
   {
     zypper.out().error(str::form(_("Unknown download mode '%s'."), download.c_str()));
     zypper.out().info(str::form(_("Available download modes: %s"),
-          "only, in-advance, in-heaps, as-needed"));
+          "only, in-advance, in-heaps, as-needed, pipelined"));
     zypper.setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
     throw ExitRequestException("Unknown download mode");
   }
@@ -526,11 +954,18 @@ DownloadMode get_download_option(Zypper & zypper, bool quiet)
   else if (mode == DownloadOnly)      MIL << "only";
   else if (mode == DownloadAsNeeded)  MIL << "as-needed";
   else                                MIL << "UNKNOWN";
+  MIL << (download == "pipelined" ? " (pipelined)" : "");
   MIL << (mode == zconfig ? " (zconfig value)" : "") << endl;
 
   return mode;
 }
 
+bool download_pipelined(Zypper & zypper)
+{
+  parsed_opts::const_iterator it = zypper.cOpts().find("download");
+  return it != zypper.cOpts().end() && it->second.front() == "pipelined";
+}
+
 // ----------------------------------------------------------------------------
 
 bool packagekit_running()
@@ -11,6 +11,7 @@
 #include <string>
 #include <set>
 #include <list>
+#include <vector>
 
 #include <zypp/Url.h>
 #include <zypp/Pathname.h>
@@ -85,8 +86,31 @@ bool looks_like_rpm_file(const std::string & s);
 zypp::Pathname cache_rpm(const std::string & rpm_uri_str,
                          const std::string & cache_dir);
 
+/**
+ * Download the RPM files specified by \a rpm_uris into \a cache_dir.
+ *
+ * Files on the same media are retrieved using a single attached media;
+ * those from remote hosts are downloaded concurrently (zypper.conf:
+ * commit.downloadJobs). Files are moved or linked into the cache rather
+ * than copied, where possible.
+ *
+ * \return The local Pathnames of the files in the cache, in the order of
+ *      \a rpm_uris; empty Pathname for the files a problem occurred with.
+ */
+std::vector<zypp::Pathname> cache_rpms(const std::vector<std::string> & rpm_uris,
+                                       const std::string & cache_dir);
+
 std::string xml_encode(const std::string & text);
 
+/** \a text escaped for a JSON string literal (without the quotes). */
+std::string json_encode(const std::string & text);
+
+/** Milliseconds on a monotonic clock, suitable for measuring intervals. */
+unsigned long long monotonic_ms();
+
+/** Microseconds on a monotonic clock, for timing short operations. */
+unsigned long long monotonic_us();
+
 std::string & indent(std::string & text, int columns);
 
 // comparator for RepoInfo set
@@ -123,8 +147,10 @@ std::string asXML(const zypp::Pattern & p, bool is_installed);
  * Used by 'zypper ps' to show running processes that use
  * libraries or other files that have been removed since their execution.
  * This is particularly useful after 'zypper remove' or 'zypper update'.
+ * With \a parallel, /proc is scanned by several threads (DeletedFilesScanner)
+ * instead of using zypp::CheckAccessDeleted.
  */
-void list_processes_using_deleted_files(Zypper & zypper);
+void list_processes_using_deleted_files(Zypper & zypper, bool parallel = false);
 
 
 /**
@@ -133,6 +159,12 @@ void list_processes_using_deleted_files(Zypper & zypper);
  */
 zypp::DownloadMode get_download_option(Zypper & zypper, bool quiet = false);
 
+/**
+ * Whether --download pipelined was given: the commit downloads as needed while
+ * a \ref PackagePrefetcher fetches the packages to come concurrently.
+ */
+bool download_pipelined(Zypper & zypper);
+
 /** Check whether packagekit is running using a DBus call */
 bool packagekit_running();
 
@@ -9,12 +9,14 @@
 #include <sstream>
 #include <fstream>
 #include <errno.h>
+#include <signal.h>
+#include <unistd.h>
 #include <sys/wait.h> //for wait()
 #include <iterator>
+#include <ext/stdio_filebuf.h>
 
 #include <zypp/base/Logger.h>
 #include <zypp/base/String.h>
-#include <zypp/TmpPath.h>
 #include <zypp/Pathname.h>
 #include <zypp/PathInfo.h>
 
@@ -51,23 +53,81 @@ static string pager_help_navigation(const string & pager)
 
 // ---------------------------------------------------------------------------
 
-static bool show_in_pager(const string & pager, const Pathname & file)
+static bool wait_for_pager(pid_t pid)
+{
+  int status = 0;
+  int ret;
+  do
+  {
+    ret = waitpid(pid, &status, 0);
+  }
+  while (ret == -1 && errno == EINTR);
+
+  if (WIFEXITED (status))
+  {
+    status = WEXITSTATUS (status);
+    if (status)
+    {
+      DBG << "Pid " << pid << " exited with status " << status << endl;
+      return false;
+    }
+    else
+      DBG << "Pid " << pid << " successfully completed" << endl;
+  }
+  else if (WIFSIGNALED (status))
+  {
+    status = WTERMSIG (status);
+    WAR << "Pid " << pid << " was killed by signal " << status
+        << " (" << strsignal(status);
+    if (WCOREDUMP (status))
+      WAR << ", core dumped";
+    WAR << ")" << endl;
+    return false;
+  }
+  else
+  {
+    ERR << "Pid " << pid << " exited with unknown error" << endl;
+    return false;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+
+bool show_in_pager(const PagerContent & content, const string & intro)
 {
   if (Zypper::instance()->globalOpts().non_interactive)
     return true;
 
+  const char* envpager = ::getenv("PAGER");
+  if (!envpager || ::strlen(envpager) == 0)
+    envpager = "more"; // basic posix default, must be in PATH
+  string pager(envpager);
+
   ostringstream cmdline;
-  cmdline << "'" << pager << "' '" << file << "'";
+  cmdline << "'" << pager << "'";
+
+  int fds[2];
+  if (::pipe(fds) == -1)
+  {
+    WAR << "pipe failed with " << strerror(errno) << endl;
+    return false;
+  }
 
-  string errmsg;
   pid_t pid;
   switch(pid = fork())
   {
   case -1:
     WAR << "fork failed" << endl;
+    ::close(fds[0]);
+    ::close(fds[1]);
     return false;
 
   case 0:
+    // the pager reads the text from stdin
+    ::dup2(fds[0], STDIN_FILENO);
+    ::close(fds[0]);
+    ::close(fds[1]);
     execlp("sh","sh","-c",cmdline.str().c_str(),(char *)0);
     WAR << "exec failed with " << strerror(errno) << endl;
     // exit, cannot return false here, because this is another process
@@ -76,122 +136,62 @@ static bool show_in_pager(const string & pager, const Pathname & file)
 
   default:
     DBG << "Executed pager process (pid: " << pid << ")" << endl;
+    ::close(fds[0]);
+  }
 
-    // wait until pager exits
-    int status = 0;
-    int ret;
-    do
-    {
-      ret = waitpid(pid, &status, 0);
-    }
-    while (ret == -1 && errno == EINTR);
-
-    if (WIFEXITED (status))
-    {
-      status = WEXITSTATUS (status);
-      if (status)
-      {
-        DBG << "Pid " << pid << " exited with status " << status << endl;
-        return false;
-      }
-      else
-        DBG << "Pid " << pid << " successfully completed" << endl;
-    }
-    else if (WIFSIGNALED (status))
-    {
-      status = WTERMSIG (status);
-      WAR << "Pid " << pid << " was killed by signal " << status
-          << " (" << strsignal(status);
-      if (WCOREDUMP (status))
-        WAR << ", core dumped";
-      WAR << ")" << endl;
-      return false;
-    }
-    else
-    {
-      ERR << "Pid " << pid << " exited with unknown error" << endl;
-      return false;
-    }
+  // The user may quit the pager before all the text is written. Writing
+  // then fails with EPIPE, which makes the stream bad and the rest of the
+  // text is skipped.
+  sighandler_t oldsigpipe = ::signal(SIGPIPE, SIG_IGN);
+  {
+    // takes ownership of fds[1], closing it tells the pager the text is complete
+    __gnu_cxx::stdio_filebuf<char> pipebuf(fds[1], std::ios::out, 64 * 1024);
+    ostream os(&pipebuf);
+
+    // intro
+    if (!intro.empty())
+      os << intro << endl;
+
+    // navigaion hint
+    string help = pager_help_navigation(pager);
+    if (!help.empty())
+      os << "(" << help << ")" << endl << endl;
+
+    // the text
+    content(os);
+
+    // exit hint
+    help = pager_help_exit(pager);
+    if (!help.empty())
+      os << endl << endl << "(" << help << ")";
+    os.flush();
   }
+  ::signal(SIGPIPE, oldsigpipe);
 
-  return true;
+  // wait until pager exits
+  return wait_for_pager(pid);
 }
 
 // ---------------------------------------------------------------------------
 
 bool show_text_in_pager(const string & text, const string & intro)
 {
-  const char* envpager = ::getenv("PAGER");
-  if (!envpager || ::strlen(envpager) == 0)
-    envpager = "more"; // basic posix default, must be in PATH
-  string pager(envpager);
-
-  filesystem::TmpFile tfile;
-  string tpath = tfile.path().absolutename().asString();
-  ofstream os(tpath.c_str());
-
-  // intro
-  if (!intro.empty())
-    os << intro << endl;
-
-  // navigaion hint
-  string help = pager_help_navigation(pager);
-  if (!help.empty())
-    os << "(" << help << ")" << endl << endl;
-
-  // the text
-  os << text;
-
-  // exit hint
-  help = pager_help_exit(pager);
-  if (!help.empty())
-    os << endl << endl << "(" << help << ")";
-  os.close();
-
-  return show_in_pager(pager, tfile);
+  return show_in_pager( [&text]( ostream & os ) { os << text; }, intro );
 }
 
 // ---------------------------------------------------------------------------
 
 bool show_file_in_pager(const Pathname & file, const string & intro)
 {
-  const char* envpager = ::getenv("PAGER");
-  if (!envpager || ::strlen(envpager) == 0)
-    envpager = "more"; // basic posix default, must be in PATH
-  string pager(envpager);
-
-  filesystem::TmpFile tfile;
-  string tpath = tfile.path().absolutename().asString();
-  ofstream os(tpath.c_str());
-
-  // intro
-  if (!intro.empty())
-    os << intro << endl;
-
-  // navigaion hint
-  string help = pager_help_navigation(pager);
-  if (!help.empty())
-    os << "(" << help << ")" << endl << endl;
-
-  // the text
   ifstream is(file.asString().c_str());
-  if (is.good())
-    os << is.rdbuf();
-  else
+  if (!is.good())
   {
     cerr << "ERR reading the file" << endl;
-    is.close();
     return false;
   }
-  is.close();
-
-  // exit hint
-  help = pager_help_exit(pager);
-  if (!help.empty())
-    os << endl << endl << "(" << help << ")";
-  os.close();
 
-  return show_in_pager(pager, tfile);
+  // streamed straight through, never held in memory
+  return show_in_pager( [&is]( ostream & os ) { os << is.rdbuf(); }, intro );
 }
 
 // vim: set ts=2 sts=2 sw=2 et ai:
@@ -9,12 +9,32 @@
 #define PAGER_H_
 
 #include <string>
+#include <iosfwd>
+#include <functional>
 
 namespace zypp
 {
   class Pathname;
 }
 
+/** Writes the text to be shown in the pager to the given stream. */
+typedef std::function<void(std::ostream &)> PagerContent;
+
+/**
+ * Opens $PAGER and streams the text written by \a content through a pipe
+ * to the pager's stdin. If $PAGER is not set, uses 'more' as a fallback.
+ *
+ * The text is not buffered, so \a content should rather stream large
+ * sources (like files) than compose them in memory first. If the pager is
+ * quit before all the text is read, the stream turns bad and further
+ * output is discarded.
+ *
+ * \param content  Writes the text to show.
+ * \param intro    Explanatory note to show at the start of the text.
+ * \return true if there was no problem opening the pager
+ */
+bool show_in_pager(const PagerContent & content, const std::string & intro = "");
+
 /**
  * Opens $PAGER with given \a text. If $PAGER is not set, uses 'more' as
  * a fallback.
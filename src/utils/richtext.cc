@@ -1,13 +1,21 @@
-#include <sstream>
-#include <map>
-#include <vector>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <string>
+#include <vector>
 
 #include <zypp/base/Logger.h>
-#include <zypp/base/String.h>
+
+#include "utils/richtext.h"
 
 using namespace std;
 
+namespace
+{
+
 enum tags {
   PARAGRAPH,
   PRE,
@@ -34,227 +42,458 @@ enum tags {
   UNKNOWN
 };
 
-std::map<string,tags> _RTtagmap;
+struct TagEntry
+{
+  const char * name;
+  tags tag;
+};
 
-bool pre;
-bool ordered;
-unsigned count_list_items;
+// sorted by name, looked up by binary search
+const TagEntry tagTable[] = {
+  { "a",		ANCHOR },
+  { "b",		BOLD },
+  { "big",		BIG },
+  { "blockquote",	BLOCKQUOTE },	// same as necurses
+  { "bold",		BOLD },
+  { "br",		BREAK_LINE },
+  { "center",		CENTER },
+  { "code",		CODE },
+  { "em",		EM },
+  { "font",		UNKNOWN },	//not parsed in parser
+  { "h1",		HEADER1 },
+  { "h2",		HEADER2 },
+  { "h3",		HEADER3 },
+  { "hr",		HR },
+  { "i",		ITALIC },
+  { "large",		UNKNOWN },	//same as ncurses
+  { "li",		LI },
+  { "ol",		OL },
+  { "p",		PARAGRAPH },
+  { "pre",		PRE },
+  { "qt",		QT },
+  { "small",		UNKNOWN },	// same as necurses
+  { "strong",		BOLD },		// same as necurses
+  { "tt",		TT },
+  { "u",		UNDERLINED },
+  { "ul",		UL },
+};
 
-void fillTagmap()
+struct EntityEntry
 {
-  _RTtagmap["p"] = PARAGRAPH;
-  _RTtagmap["a"] = ANCHOR;
-  _RTtagmap["b"] = BOLD;
-  _RTtagmap["u"] = UNDERLINED;
-  _RTtagmap["i"] = ITALIC;
-  _RTtagmap["br"] = BREAK_LINE;
-  _RTtagmap["em"] = EM;
-  _RTtagmap["h1"] = HEADER1;
-  _RTtagmap["h2"] = HEADER2;
-  _RTtagmap["h3"] = HEADER3;
-  _RTtagmap["hr"] = HR;
-  _RTtagmap["li"] = LI;
-  _RTtagmap["ol"] = OL;
-  _RTtagmap["ul"] = UL;
-  _RTtagmap["qt"] = QT;
-  _RTtagmap["tt"] = TT;
-  _RTtagmap["big"] = BIG;
-  _RTtagmap["pre"] = PRE;
-  _RTtagmap["bold"] = BOLD;
-  _RTtagmap["code"] = CODE;
-  _RTtagmap["font"] = UNKNOWN; //not parsed in parser
-  _RTtagmap["large"] = UNKNOWN; //same as ncurses
-  _RTtagmap["small"] = UNKNOWN; // same as necurses
-  _RTtagmap["center"] = CENTER;
-  _RTtagmap["strong"] = BOLD; // same as necurses
-  _RTtagmap["blockquote"] = BLOCKQUOTE; // same as necurses
-  
+  const char * name;
+  const char * value;
+};
+
+// sorted by name, looked up by binary search
+const EntityEntry entityTable[] = {
+  { "amp",	"&" },
+  { "apos",	"'" },
+  { "gt",	">" },
+  { "lt",	"<" },
+  { "nbsp",	" " },		//TODO REAL NBSP
+  { "product",	"product" },	//TODO replace with real name
+  { "quot",	"\"" },
+};
+
+/** Compare a table entry's name with \a name_r of length \a len_r. */
+inline int compareName( const char * entry_r, const char * name_r, size_t len_r )
+{
+  int cmp = ::strncmp( entry_r, name_r, len_r );
+  if ( cmp )
+    return cmp;
+  return entry_r[len_r] == '\0' ? 0 : 1;
 }
 
-string closeTag(vector<tags>& tagStack)
+/** Lookup \a name_r of length \a len_r in a table sorted by \c name. */
+template <class _Entry, size_t _Size>
+const _Entry * lookup( const _Entry (&table_r)[_Size], const char * name_r, size_t len_r )
 {
-  if(tagStack.empty())
-  {
-    WAR << "closing tag before any opening" << endl;;
-    return "";
-  }
-  tags t = tagStack.back();
-  tagStack.pop_back();
-  switch(t)
+  size_t lo = 0;
+  size_t hi = _Size;
+  while ( lo < hi )
   {
-    case PARAGRAPH:
-      return "\n\n";
-    case LI:
-      return "\n";
-    case PRE:
-      pre = false; //fall thrue
-    default:
-      return "";
+    size_t mid = ( lo + hi ) / 2;
+    int cmp = compareName( table_r[mid].name, name_r, len_r );
+    if ( cmp == 0 )
+      return &table_r[mid];
+    if ( cmp < 0 )
+      lo = mid + 1;
+    else
+      hi = mid;
   }
+  return 0;
 }
 
-string openTag(vector<tags>& tagStack, string& tag)
+/** Appends to a std::string. */
+struct StringSink
 {
-  tag = zypp::str::trim(tag);
-  std::map<string,tags>::const_iterator it = _RTtagmap.find(tag);
-  tags t;
-  if (it == _RTtagmap.end())
-  {
-    if (tag.size()>3 && tag[0]=='!' && tag[1]=='-' && tag[2]=='-')
-      return ""; //comment
-    WAR << "unknown rich text tag "<<tag << endl;
-    t = UNKNOWN;
-  }
-  else
+  StringSink( std::string & str_r ) : _str( str_r ) {}
+
+  void put( char ch_r )
+  { _str.push_back( ch_r ); }
+
+  void put( const char * str_r, size_t len_r )
+  { _str.append( str_r, len_r ); }
+
+  std::string & _str;
+};
+
+/** Buffered writing to a std::ostream. */
+struct StreamSink
+{
+  StreamSink( std::ostream & str_r ) : _str( str_r ), _len( 0 ) {}
+  ~StreamSink() { flush(); }
+
+  void put( char ch_r )
   {
-    t = it->second;
+    if ( _len == sizeof(_buf) )
+      flush();
+    _buf[_len++] = ch_r;
   }
-  tagStack.push_back(t);
-  switch(t)
+
+  void put( const char * str_r, size_t len_r )
   {
-    case HR:
-      tagStack.pop_back(); //hr haven't closing tag
-      return "--------------------";
-    
-    case PARAGRAPH:
-      return "";
-    case BREAK_LINE:
-      tagStack.pop_back(); //br haven't closing tag
-      return "\n";
-    case OL:
-      ordered = true;
-      count_list_items = 0;
-      return "\n";
-    case UL:
-      ordered = false;
-      return "\n";
-    case LI:
-      if (ordered)
-      {
-        ostringstream res;
-        res << ++count_list_items << ") ";
-        res.flush();
-        return res.str();
-      }
-      else
+    if ( _len + len_r > sizeof(_buf) )
+    {
+      flush();
+      if ( len_r >= sizeof(_buf) )
       {
-        return "- ";
+        _str.write( str_r, len_r );
+        return;
       }
-    case PRE:
-      pre = true; //fall thrue
-    default:
-      return "";
+    }
+    ::memcpy( _buf + _len, str_r, len_r );
+    _len += len_r;
   }
-}
 
-std::map<string,string> ampersmap;
+  void flush()
+  {
+    if ( _len )
+    {
+      _str.write( _buf, _len );
+      _len = 0;
+    }
+  }
 
-void fillAmpersmap()
-{
-  ampersmap["gt"]=">";
-  ampersmap["lt"]="<";
-  ampersmap["amp"]="&";
-  ampersmap["quot"]="\"";
-  ampersmap["nbsp"]=" "; //TODO REAL NBSP
-  ampersmap["product"]="product"; //TODO replace with real name
-}
+  std::ostream & _str;
+  char _buf[8192];
+  size_t _len;
+};
 
-string getStringFromAmpr(const string& str)
+///////////////////////////////////////////////////////////////////
+/// \class RichTextConverter
+/// \brief Single pass rich text to plain text state machine.
+///
+/// Text may be fed in arbitrary chunks; tags and entities split
+/// across chunks are kept in a small fixed size buffer, so memory
+/// use does not depend on the document size.
+///////////////////////////////////////////////////////////////////
+template <class _Sink>
+class RichTextConverter
 {
-  if (ampersmap.empty())
-    fillAmpersmap();
+public:
+  RichTextConverter( _Sink & sink_r )
+  : _sink( sink_r )
+  , _state( TEXT )
+  , _pre( false )
+  , _ordered( false )
+  , _count_list_items( 0 )
+  , _len( 0 )
+  {}
 
-  string::size_type end = str.find(';');
-  DBG << "val ampr is: " << str << endl;
-  if (str[0] == '#') //first is value
+  void feed( const char * begin_r, const char * end_r )
   {
-    int res = 0;
-    istringstream sstr(str.substr(1,end));
-    sstr >> res;
-    DBG << res << endl;
-    if (res!=0)
-    {
-      return string(1,(char)res); //return char
-    }
-    else
+    while ( begin_r != end_r )
     {
-      WAR << "unknown number " << str << endl;
-      return "";
+      if ( _state == TEXT )
+      {
+        // pass plain text through in runs
+        const char * run = begin_r;
+        while ( begin_r != end_r && ! special( *begin_r ) )
+          ++begin_r;
+        if ( begin_r != run )
+          _sink.put( run, begin_r - run );
+        if ( begin_r == end_r )
+          break;
+      }
+      put( *begin_r++ );
     }
   }
-  
-  DBG << end <<" "<<str.substr(0,end) << endl;
-  return ampersmap[str.substr(0,end)];
-
-}
 
-std::string processRichText(const std::string& text)
-{
-  if (_RTtagmap.empty())
-    fillTagmap();
-  //state machine vars
-  pre = false;
+  void finish()
+  {
+    if ( _state == TAG )
+      WAR << "ended with non-closed tag." << endl;
+    else if ( _state == ENTITY )
+      literalEntity();
+    _state = TEXT;
+  }
 
-  vector<tags> tagStack;
+private:
+  enum State { TEXT, TAG, ENTITY };
 
-  string res("");
-  res.reserve(text.size());
-  string::size_type pos = 0;
-  do {
-    switch( text[pos] )
+  static bool special( char ch_r )
+  {
+    switch ( ch_r )
     {
-      case ' ':
+      case '<':
+      case '&':
       case '\n':
       case '\t':
       case '\v':
       case '\r':
-        if (pre)
-          res.push_back(text[pos]);
-        else
+        return true;
+    }
+    return false;
+  }
+
+  void put( char ch_r )
+  {
+    switch ( _state )
+    {
+      case TEXT:
+        switch ( ch_r )
         {
-          if (text[pos]==' ')
-            res.push_back(' ');
+          case '<':
+            _state = TAG;
+            _len = 0;
+            break;
+          case '&':
+            _state = ENTITY;
+            _len = 0;
+            break;
+          case '\n':
+          case '\t':
+          case '\v':
+          case '\r':
+            if ( _pre )
+              _sink.put( ch_r );
+            break;
+          default:
+            _sink.put( ch_r );
         }
         break;
-      case '<':
-        if (pos+1==text.npos)
+
+      case TAG:
+        if ( ch_r == '>' )
         {
-          WAR << "ended with nonclosed tag."<< endl;
-          return res; //chyba, tohle by se nemelo stavat
+          _state = TEXT;
+          tag();
         }
-        if (text[pos+1]=='/') //close tag
+        else if ( _len < sizeof(_buf) )
+          _buf[_len++] = ch_r;	// the rest of long attributes is not needed
+        break;
+
+      case ENTITY:
+        if ( ch_r == ';' )
         {
-          pos = text.find('>',pos);
-          res.append(closeTag(tagStack));
+          _state = TEXT;
+          entity();
         }
+        else if ( _len < maxEntityLen && ( ::isalnum( (unsigned char)ch_r ) || ( ch_r == '#' && _len == 0 ) ) )
+          _buf[_len++] = ch_r;
         else
         {
-          string::size_type tagEndPos = text.find('>',pos);
-          if(tagEndPos==text.npos)
-          {
-            WAR << "ended with non-closed tag " << endl;
-            return res; 
-          }
-          string tagname = text.substr(pos+1,tagEndPos-pos-1);
-          pos = tagEndPos;
-          res.append(openTag(tagStack,tagname));
+          // not an entity after all
+          literalEntity();
+          _state = TEXT;
+          put( ch_r );
         }
         break;
-      case '&':
-      {
-        string::size_type semipos = text.find(';',pos);
-        string tmp = getStringFromAmpr(text.substr(pos+1,pos-semipos-1));
-        DBG << "tmp is: " << tmp << endl;
-        res.append(tmp);
-        pos = semipos;
+    }
+  }
+
+  void literalEntity()
+  {
+    _sink.put( '&' );
+    _sink.put( _buf, _len );
+  }
+
+  void tag()
+  {
+    char * p = _buf;
+    char * end = _buf + _len;
+    while ( p != end && ::isspace( (unsigned char)*p ) )
+      ++p;
+
+    if ( p == end )
+      return;
+    if ( *p == '/' )
+    {
+      closeTag();
+      return;
+    }
+    if ( *p == '!' || *p == '?' )
+      return; // comment or declaration
+
+    // tag name, attributes are ignored
+    char * name = p;
+    size_t len = 0;
+    while ( p != end && ! ::isspace( (unsigned char)*p ) && *p != '/' )
+    {
+      name[len++] = ::tolower( (unsigned char)*p );
+      ++p;
+    }
+
+    const TagEntry * entry = lookup( tagTable, name, len );
+    if ( ! entry )
+      WAR << "unknown rich text tag " << std::string( name, len ) << endl;
+    openTag( entry ? entry->tag : UNKNOWN );
+  }
+
+  void closeTag()
+  {
+    if ( _tagStack.empty() )
+    {
+      WAR << "closing tag before any opening" << endl;
+      return;
+    }
+    tags t = _tagStack.back();
+    _tagStack.pop_back();
+    switch ( t )
+    {
+      case PARAGRAPH:
+        _sink.put( "\n\n", 2 );
+        break;
+      case LI:
+        _sink.put( '\n' );
+        break;
+      case PRE:
+        _pre = false;
         break;
-      }
       default:
-        res.push_back(text[pos]);
+        break;
     }
+  }
 
-    ++pos;
-  } while (pos!=text.size());
+  void openTag( tags t )
+  {
+    switch ( t )
+    {
+      case HR: //hr haven't closing tag
+        _sink.put( "--------------------", 20 );
+        return;
+      case BREAK_LINE: //br haven't closing tag
+        _sink.put( '\n' );
+        return;
+      case OL:
+        _ordered = true;
+        _count_list_items = 0;
+        _sink.put( '\n' );
+        break;
+      case UL:
+        _ordered = false;
+        _sink.put( '\n' );
+        break;
+      case LI:
+        if ( _ordered )
+        {
+          char num[16];
+          int len = ::snprintf( num, sizeof(num), "%u) ", ++_count_list_items );
+          _sink.put( num, len );
+        }
+        else
+          _sink.put( "- ", 2 );
+        break;
+      case PRE:
+        _pre = true;
+        break;
+      default:
+        break;
+    }
+    _tagStack.push_back( t );
+  }
+
+  void entity()
+  {
+    if ( _len && _buf[0] == '#' )
+    {
+      // numeric character reference, decimal or hex
+      _buf[_len] = '\0';	// _len <= maxEntityLen
+      unsigned long code = 0;
+      if ( _len > 1 && ( _buf[1] == 'x' || _buf[1] == 'X' ) )
+        code = ::strtoul( _buf + 2, 0, 16 );
+      else
+        code = ::strtoul( _buf + 1, 0, 10 );
+      if ( code )
+        putUtf8( code );
+      else
+        WAR << "unknown number " << std::string( _buf, _len ) << endl;
+      return;
+    }
+
+    const EntityEntry * entry = lookup( entityTable, _buf, _len );
+    if ( entry )
+      _sink.put( entry->value, ::strlen( entry->value ) );
+  }
+
+  void putUtf8( unsigned long code_r )
+  {
+    char out[4];
+    size_t len = 0;
+    if ( code_r < 0x80 )
+      out[len++] = code_r;
+    else if ( code_r < 0x800 )
+    {
+      out[len++] = 0xC0 | ( code_r >> 6 );
+      out[len++] = 0x80 | ( code_r & 0x3F );
+    }
+    else if ( code_r < 0x10000 )
+    {
+      out[len++] = 0xE0 | ( code_r >> 12 );
+      out[len++] = 0x80 | ( ( code_r >> 6 ) & 0x3F );
+      out[len++] = 0x80 | ( code_r & 0x3F );
+    }
+    else if ( code_r < 0x110000 )
+    {
+      out[len++] = 0xF0 | ( code_r >> 18 );
+      out[len++] = 0x80 | ( ( code_r >> 12 ) & 0x3F );
+      out[len++] = 0x80 | ( ( code_r >> 6 ) & 0x3F );
+      out[len++] = 0x80 | ( code_r & 0x3F );
+    }
+    _sink.put( out, len );
+  }
+
+private:
+  static const size_t maxEntityLen = 10;
+
+  _Sink & _sink;
+  State _state;
+  bool _pre;
+  bool _ordered;
+  unsigned _count_list_items;
+  std::vector<tags> _tagStack;
+  char _buf[64];	//< pending tag or entity
+  size_t _len;
+};
+
+} // namespace
+
+std::string processRichText(const std::string& text)
+{
+  std::string res;
+  res.reserve(text.size());
+  StringSink sink(res);
+  RichTextConverter<StringSink> conv(sink);
+  conv.feed(text.data(), text.data() + text.size());
+  conv.finish();
   return res;
 }
 
+void processRichText(const std::string& text, std::ostream & out)
+{
+  StreamSink sink(out);
+  RichTextConverter<StreamSink> conv(sink);
+  conv.feed(text.data(), text.data() + text.size());
+  conv.finish();
+}
+
+void processRichText(std::istream & in, std::ostream & out)
+{
+  StreamSink sink(out);
+  RichTextConverter<StreamSink> conv(sink);
+  char buf[8192];
+  while (in.read(buf, sizeof(buf)) || in.gcount())
+    conv.feed(buf, buf + in.gcount());
+  conv.finish();
+}
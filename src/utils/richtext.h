@@ -2,9 +2,19 @@
 #define ZYPPERRICHTEXT_H_
 
 
+#include <iosfwd>
 #include <string>
 
+/** Convert rich text (the HTML subset used in licenses and descriptions)
+ * to plain text for the terminal. */
 std::string processRichText(const std::string& text);
 
-#endif
+/** \overload Write the converted \a text to \a out. */
+void processRichText(const std::string& text, std::ostream & out);
+
+/** \overload Convert rich text read from \a in and write it to \a out.
+ * The document is converted in a single pass in chunks and is never held
+ * in memory as a whole. */
+void processRichText(std::istream & in, std::ostream & out);
 
+#endif
@@ -5,7 +5,10 @@
                              |__/|_|  |_|
 \*---------------------------------------------------------------------------*/
 
+#include <sstream>
+
 #include "TestSetup.h"
+#include "Zypper.h"
 #include "PackageArgs.h"
 
 using namespace std;
@@ -217,4 +220,47 @@ BOOST_AUTO_TEST_CASE(argToCaps_with_patch_test)
   }
 }
 
+BOOST_AUTO_TEST_CASE(manifest_test)
+{
+  istringstream manifest(
+      "# packages to install\n"
+      "zypper\n"
+      "\n"
+      "  libzypp >= 6.30.0   # the new one\n"
+      "\t-vim\n"
+      "+emacs\n");
+
+  PackageArgs args(manifest);
+  set<string> sargs = args.asStringSet();
+
+  BOOST_CHECK((sargs.find("zypper") != sargs.end()));
+  BOOST_CHECK((sargs.find("libzypp>=6.30.0") != sargs.end()));
+  BOOST_CHECK((sargs.find("-vim") != sargs.end()));
+  BOOST_CHECK((sargs.find("+emacs") != sargs.end()));
+  BOOST_CHECK_EQUAL(sargs.size(), 4);
+  BOOST_CHECK_EQUAL(args.dos().size(), 3);
+  BOOST_CHECK_EQUAL(args.donts().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(manifest_whitespace_test)
+{
+  {
+    istringstream manifest(
+        "libzypp>= 6.30.0\n"
+        "zypper <1.9\n"
+        "vim = 7.3\n");
+    PackageArgs args(manifest);
+    set<string> sargs = args.asStringSet();
+    BOOST_CHECK((sargs.find("libzypp>=6.30.0") != sargs.end()));
+    BOOST_CHECK((sargs.find("zypper<1.9") != sargs.end()));
+    BOOST_CHECK((sargs.find("vim=7.3") != sargs.end()));
+    BOOST_CHECK_EQUAL(sargs.size(), 3);
+  }
+  {
+    // not 'foobar'
+    istringstream manifest("zypper\nfoo bar\n");
+    BOOST_CHECK_THROW(PackageArgs args(manifest), ExitRequestException);
+  }
+}
+
 // vim: set ts=2 sts=8 sw=2 ai et:
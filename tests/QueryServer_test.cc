@@ -0,0 +1,48 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include "TestSetup.h"
+#include "utils/misc.h"
+#include "QueryServer.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(parse_request_test)
+{
+  vector<string> args;
+  BOOST_CHECK(QueryServer::parseRequest("[\"search\", \"-s\", \"vim\"]", args));
+  BOOST_REQUIRE_EQUAL(args.size(), 3);
+  BOOST_CHECK_EQUAL(args[0], "search");
+  BOOST_CHECK_EQUAL(args[2], "vim");
+
+  BOOST_CHECK(QueryServer::parseRequest(" [ \"a\\\"b\\\\c\\n\", \"\\u00e9\\ud83d\\ude00\" ] ", args));
+  BOOST_REQUIRE_EQUAL(args.size(), 2);
+  BOOST_CHECK_EQUAL(args[0], "a\"b\\c\n");
+  BOOST_CHECK_EQUAL(args[1], "\xc3\xa9\xf0\x9f\x98\x80");
+
+  BOOST_CHECK(QueryServer::parseRequest("[]", args));
+  BOOST_CHECK(args.empty());
+
+  BOOST_CHECK(!QueryServer::parseRequest("", args));
+  BOOST_CHECK(!QueryServer::parseRequest("[\"search\"", args));
+  BOOST_CHECK(!QueryServer::parseRequest("[\"search\",]", args));
+  BOOST_CHECK(!QueryServer::parseRequest("[\"search\"] x", args));
+  BOOST_CHECK(!QueryServer::parseRequest("[search]", args));
+  BOOST_CHECK(!QueryServer::parseRequest("{\"command\": \"search\"}", args));
+}
+
+BOOST_AUTO_TEST_CASE(json_encode_test)
+{
+  BOOST_CHECK_EQUAL(json_encode("vim"), "vim");
+  BOOST_CHECK_EQUAL(json_encode("a \"b\"\\\n\t\x1b"), "a \\\"b\\\"\\\\\\n\\t\\u001b");
+
+  vector<string> args;
+  string str("line 1\nline \"2\"\n\xc3\xa9");
+  BOOST_CHECK(QueryServer::parseRequest("[\"" + json_encode(str) + "\"]", args));
+  BOOST_REQUIRE_EQUAL(args.size(), 1);
+  BOOST_CHECK_EQUAL(args[0], str);
+}
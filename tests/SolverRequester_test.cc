@@ -894,6 +894,74 @@ BOOST_AUTO_TEST_CASE(update3)
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+// bulk
+///////////////////////////////////////////////////////////////////////////
+
+// request : install all package names from the main repo, nonsense, a glob
+//           and a versioned package
+// response: the names looked up in the name index do what install2/3/4 do
+//           one by one, the rest still work via PoolQuery
+BOOST_AUTO_TEST_CASE(bulk1)
+{
+  MIL << "<============bulk1===============>" << endl;
+
+  set<string> names;
+  PoolQuery q;
+  q.addRepo("main");
+  q.addKind(ResKind::package);
+  for_(it, q.begin(), q.end())
+    names.insert(it->name());
+  BOOST_REQUIRE(names.size() > 1000);
+
+  vector<string> rawargs(names.begin(), names.end());
+  rawargs.push_back("nonsense");
+  rawargs.push_back("vim-enh*");
+  rawargs.push_back("info=4.12-1.111");
+  SolverRequester sr;
+
+  sr.install(rawargs);
+
+  BOOST_CHECK(hasPoolItem(sr.toInstall(), "vim", Edition("7.2-7.4.1"), Arch_x86_64));
+  BOOST_CHECK(hasPoolItem(sr.toInstall(), "zypper", Edition("1.0.13-0.1.1"), Arch_x86_64));
+  BOOST_CHECK(hasPoolItem(sr.toInstall(), "vim-enhanced"));
+  BOOST_CHECK(hasPoolItem(sr.toInstall(), "info", Edition("4.12-1.111"), Arch_x86_64));
+  BOOST_CHECK(!hasPoolItem(sr.toInstall(), "netcfg"));
+  BOOST_CHECK(sr.hasFeedback(SolverRequester::Feedback::ALREADY_INSTALLED));
+  BOOST_CHECK(sr.hasFeedback(SolverRequester::Feedback::NOT_FOUND_NAME_TRYING_CAPS));
+  BOOST_CHECK(sr.hasFeedback(SolverRequester::Feedback::NOT_FOUND_CAP));
+
+  // leave the pool as it was for any later tests
+  for_(it, sr.toInstall().begin(), sr.toInstall().end())
+    it->status().resetTransact(ResStatus::USER);
+}
+
+// request : remove an installed, a not installed, and many unknown names
+// response: the installed one set to remove, the rest not installed or
+//           not found
+BOOST_AUTO_TEST_CASE(bulk2)
+{
+  MIL << "<============bulk2===============>" << endl;
+
+  vector<string> rawargs;
+  rawargs.push_back("netcfg");
+  rawargs.push_back("vim");
+  for (unsigned i = 0; i < SolverRequester::bulk_threshold; ++i)
+    rawargs.push_back(str::form("nonsense%u", i));
+  SolverRequester sr;
+
+  sr.remove(rawargs);
+
+  BOOST_CHECK_EQUAL(sr.toRemove().size(), 1);
+  BOOST_CHECK(hasPoolItem(sr.toRemove(), "netcfg"));
+  BOOST_CHECK(sr.hasFeedback(SolverRequester::Feedback::NOT_INSTALLED));
+  BOOST_CHECK(sr.hasFeedback(SolverRequester::Feedback::NO_INSTALLED_PROVIDER));
+
+  for_(it, sr.toRemove().begin(), sr.toRemove().end())
+    it->status().resetTransact(ResStatus::USER);
+}
+
+
 // request :
 // response:
 /*BOOST_AUTO_TEST_CASE(installX)
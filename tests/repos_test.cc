@@ -0,0 +1,45 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include "TestSetup.h"
+#include "repos.h"
+
+using namespace std;
+
+// the shell re-initializes the repos if the selection differs from the
+// previous command's
+BOOST_AUTO_TEST_CASE(repos_selection_test)
+{
+  parsed_opts opts;
+  vector<string> none;
+  string all(repos_selection(opts, none));
+
+  // search -r foo x
+  opts["repo"].push_back("foo");
+  string foo(repos_selection(opts, none));
+  BOOST_CHECK(foo != all);
+
+  // search x
+  opts.clear();
+  BOOST_CHECK_EQUAL(repos_selection(opts, none), all);
+
+  // install -r bar y
+  opts["repo"].push_back("bar");
+  string bar(repos_selection(opts, none));
+  BOOST_CHECK(bar != all);
+  BOOST_CHECK(bar != foo);
+
+  // rug's --catalog, and the repos given to init_repos(), select them too
+  opts.clear();
+  opts["catalog"].push_back("bar");
+  BOOST_CHECK_EQUAL(repos_selection(opts, none), bar);
+  opts.clear();
+  BOOST_CHECK_EQUAL(repos_selection(opts, vector<string>(1, "bar")), bar);
+
+  opts["repo"].push_back("foo");
+  BOOST_CHECK(repos_selection(opts, vector<string>(1, "bar")) != foo);
+}
@@ -0,0 +1,61 @@
+#include <sstream>
+#include <fstream>
+
+#include "TestSetup.h"
+#include "utils/ConfigReader.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(parse_test)
+{
+  ConfigReader::Options options;
+  istringstream in(
+    "## Configuration file for Zypper.\n"
+    "\n"
+    "[main]\n"
+    "## Whether to show the alias\n"
+    "# showAlias = no\n"
+    "showAlias = yes\n"
+    "  repoListColumns =  anr \t\n"
+    "[solver]\n"
+    "forceResolutionCommands = remove, install\n"
+    "[color]\n"
+    "result = white");
+  BOOST_CHECK(ConfigReader::parse(in, options));
+  BOOST_CHECK_EQUAL(options.size(), 4);
+  BOOST_CHECK_EQUAL(options["main/showAlias"], "yes");
+  BOOST_CHECK_EQUAL(options["main/repoListColumns"], "anr");
+  BOOST_CHECK_EQUAL(options["solver/forceResolutionCommands"], "remove, install");
+  BOOST_CHECK_EQUAL(options["color/result"], "white");
+}
+
+// what is left to Augeas
+BOOST_AUTO_TEST_CASE(parse_unhandled_test)
+{
+  const char * unhandled[] = {
+    "showAlias = yes\n",                        // no section
+    "[main]\nshowAlias\n",                      // no value
+    "[main]\nshowAlias =\n",
+    "[main]\nshow alias = yes\n",
+    "[main]\nsh\xc3\xb6wAlias = yes\n",         // not ASCII
+    "[main]\n; showAlias = yes\n",
+    "[ma in]\n",
+    "[main]\nshowAlias = yes\nshowAlias = no\n", // twice
+    0
+  };
+  for (const char ** it = unhandled; *it; ++it)
+  {
+    ConfigReader::Options options;
+    istringstream in(*it);
+    BOOST_CHECK_MESSAGE(!ConfigReader::parse(in, options), *it);
+  }
+}
+
+// the default config must not need Augeas
+BOOST_AUTO_TEST_CASE(parse_default_conf_test)
+{
+  ConfigReader::Options options;
+  ifstream in(TESTS_SRC_DIR "/../zypper.conf");
+  BOOST_REQUIRE(in);
+  BOOST_CHECK(ConfigReader::parse(in, options));
+}
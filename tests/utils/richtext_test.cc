@@ -0,0 +1,47 @@
+#include <sstream>
+
+#include "TestSetup.h"
+#include "utils/richtext.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(richtext_tags_test)
+{
+  BOOST_CHECK_EQUAL(processRichText("<p>Hello</p>world"), string("Hello\n\nworld"));
+  BOOST_CHECK_EQUAL(processRichText("a<br>b<br/>c<hr>"), string("a\nb\nc--------------------"));
+  BOOST_CHECK_EQUAL(processRichText("<ol><li>a</li><li>b</li></ol>"), string("\n1) a\n2) b\n"));
+  BOOST_CHECK_EQUAL(processRichText("<UL><li>a</li></UL>"), string("\n- a\n"));
+  // attributes, comments and unknown tags are dropped
+  BOOST_CHECK_EQUAL(processRichText("<!-- x --><p align=\"center\">a</p><foo>b</foo>"), string("a\n\nb"));
+}
+
+BOOST_AUTO_TEST_CASE(richtext_whitespace_test)
+{
+  // line breaks are markup outside of <pre>
+  BOOST_CHECK_EQUAL(processRichText("a\nb c\td"), string("ab cd"));
+  BOOST_CHECK_EQUAL(processRichText("<pre>a\nb\tc</pre>\nd"), string("a\nb\tcd"));
+}
+
+BOOST_AUTO_TEST_CASE(richtext_entities_test)
+{
+  BOOST_CHECK_EQUAL(processRichText("&lt;a&gt; &amp; &quot;b&quot;&nbsp;"), string("<a> & \"b\" "));
+  BOOST_CHECK_EQUAL(processRichText("&#65;&#x42;&#269;"), string("AB\xc4\x8d"));
+  // not an entity
+  BOOST_CHECK_EQUAL(processRichText("R&D &"), string("R&D &"));
+}
+
+BOOST_AUTO_TEST_CASE(richtext_stream_test)
+{
+  // large document, converted as a stream and as a whole
+  string doc;
+  for (unsigned i = 0; i < 10000; ++i)
+    doc += "<p>PLEASE READ THIS AGREEMENT <b>CAREFULLY</b> &amp; <i>completely</i>.\n</p><ol><li>one</li></ol>";
+
+  istringstream in(doc);
+  ostringstream out;
+  processRichText(in, out);
+  BOOST_CHECK_EQUAL(out.str(), processRichText(doc));
+  BOOST_CHECK_EQUAL(out.str().size(), 10000 * string("PLEASE READ THIS AGREEMENT CAREFULLY & completely.\n\n\n1) one\n").size());
+}
+
+// vim: set ts=2 sts=8 sw=2 ai et: